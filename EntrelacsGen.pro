@@ -4,10 +4,25 @@
 #
 #-------------------------------------------------
 
-QT       += core gui
+QT       += core gui concurrent network
 
 greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
 
+# store coordinates as float: qmake CONFIG+=compact_coords
+compact_coords {
+    DEFINES += ENTRELACS_COMPACT_COORDS
+}
+
+# make check: --check every test graph, with double coordinates, then
+# with a float coordinates build in compact_coords/
+check.commands = \
+    for g in $$PWD/test/*.grp; do ./$$TARGET --check $$$$g || exit 1; done && \
+    mkdir -p compact_coords && cd compact_coords && \
+    $$QMAKE_QMAKE CONFIG+=compact_coords $$_PRO_FILE_ && $(MAKE) && \
+    for g in $$PWD/test/*.grp; do ./$$TARGET --check $$$$g || exit 1; done
+check.depends = $(TARGET)
+QMAKE_EXTRA_TARGETS += check
+
 TARGET = EntrelacsGen
 TEMPLATE = app
 
@@ -15,11 +30,38 @@ TEMPLATE = app
 SOURCES += main.cpp\
         mainwindow.cpp \
     graph.cpp \
-    graphdrawer.cpp
+    graphdrawer.cpp \
+    blockwriter.cpp \
+    entrelacwriter.cpp \
+    pipeline.cpp \
+    graphbuilder.cpp \
+    symmetry.cpp \
+    generationserver.cpp \
+    generationclient.cpp \
+    ribbon.cpp \
+    entrelacgenerator.cpp \
+    curveflattener.cpp \
+    entrelacbinary.cpp \
+    consistencycheck.cpp
 
 HEADERS  += mainwindow.h \
     graph.h \
-    graphdrawer.h
+    graphdrawer.h \
+    blockwriter.h \
+    entrelacwriter.h \
+    boundedqueue.h \
+    pipeline.h \
+    graphbuilder.h \
+    symmetry.h \
+    generationserver.h \
+    generationclient.h \
+    ribbon.h \
+    entrelacgenerator.h \
+    entrelacpolicy.h \
+    curveflattener.h \
+    coords.h \
+    entrelacbinary.h \
+    consistencycheck.h
 
 FORMS    += mainwindow.ui
 
@@ -30,4 +72,11 @@ DISTFILES += \
     test/triangle.grp \
     test/tristar.grp \
     test/quadstar.grp \
-    test/square.grp
+    test/square.grp \
+    test/trinode.ent \
+    test/binode.ent \
+    test/cube.ent \
+    test/triangle.ent \
+    test/tristar.ent \
+    test/quadstar.ent \
+    test/square.ent
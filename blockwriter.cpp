@@ -0,0 +1,81 @@
+#include "blockwriter.h"
+
+#include <QTextStream>
+#include <QIODevice>
+#include <QLocale>
+#include <QTextCodec>
+
+static bool writes_ascii_as_is(QTextStream *output)
+{
+    /* every character the writers emit */
+    static const char probe[]="\n #+-.0123456789;=>[]"
+                              "abcdefghijklmnopqrstuvwxyz";
+    QTextCodec *codec=output->codec();
+    if (codec==nullptr||output->generateByteOrderMark()) {
+        return false;
+    }
+    return (codec->fromUnicode(QLatin1String(probe))==QByteArray(probe));
+}
+
+BlockWriter::~BlockWriter()
+{
+    flush();
+}
+
+BlockWriter::BlockWriter(QTextStream *output, int block_size) :
+    _output(output),
+    _buffer(),
+    _block_size(block_size),
+    _raw(output!=nullptr&&writes_ascii_as_is(output)),
+    _ok(true)
+{
+    /* reserved capacity is kept when buffer is emptied */
+    _buffer.reserve(_block_size+256);
+}
+
+void BlockWriter::append(const QByteArray &data)
+{
+    _buffer.append(data);
+    flush_if_full();
+}
+
+void BlockWriter::append_uint(uint value)
+{
+    char digits[16];
+    int len=0;
+    do {
+        digits[len++]='0'+(value%10);
+        value/=10;
+    } while (value!=0);
+    while (len>0) {
+        _buffer.append(digits[--len]);
+    }
+    flush_if_full();
+}
+
+void BlockWriter::append_real(double value)
+{
+    /* shortest representation reading back to the same double */
+    _buffer.append(QByteArray::number(value, 'g',
+                                      QLocale::FloatingPointShortest));
+    flush_if_full();
+}
+
+bool BlockWriter::flush()
+{
+    QIODevice *device;
+    if (_output==nullptr||_buffer.isEmpty()) {
+        return _ok;
+    }
+    device=_output->device();
+    if (_raw&&device!=nullptr) {
+        /* bypass text stream encoding, it would not change ASCII */
+        _output->flush();
+        _ok=_ok&&(device->write(_buffer)==_buffer.size());
+    } else {
+        (*_output) << QLatin1String(_buffer.constData(), _buffer.size());
+        _ok=_ok&&(_output->status()==QTextStream::Ok);
+    }
+    _buffer.resize(0);
+    return _ok;
+}
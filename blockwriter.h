@@ -0,0 +1,49 @@
+#ifndef BLOCKWRITER_H
+#define BLOCKWRITER_H
+
+#include <QByteArray>
+
+class QTextStream;
+
+#define BLOCK_WRITER_SIZE (1<<20)
+
+/*
+ * Buffered writer formatting numbers directly into a byte buffer and
+ * emitting it in large blocks. Without output stream, data accumulates
+ * in memory and can be retrieved with data() (used for parallel chunks).
+ * Blocks go straight to the stream device when the stream codec writes
+ * ASCII unchanged, through the stream otherwise (e.g. UTF-16).
+ */
+class BlockWriter
+{
+private:
+    QTextStream *_output;
+    QByteArray _buffer;
+    int _block_size;
+    bool _raw;
+    bool _ok;
+public:
+    virtual ~BlockWriter();
+    BlockWriter(QTextStream *output=nullptr, int block_size=BLOCK_WRITER_SIZE);
+
+    inline bool ok() const
+    { return _ok; }
+    inline const QByteArray &data() const
+    { return _buffer; }
+
+    inline void append(char c)
+    { _buffer.append(c); flush_if_full(); }
+    inline void append(const char *str)
+    { _buffer.append(str); flush_if_full(); }
+    void append(const QByteArray &data);
+    void append_uint(uint value);
+    void append_real(double value);
+
+    bool flush();
+
+private:
+    inline void flush_if_full()
+    { if (_output!=nullptr&&_buffer.size()>=_block_size) { flush(); } }
+};
+
+#endif // BLOCKWRITER_H
@@ -0,0 +1,67 @@
+#ifndef BOUNDEDQUEUE_H
+#define BOUNDEDQUEUE_H
+
+#include <QMutex>
+#include <QMutexLocker>
+#include <QWaitCondition>
+#include <QQueue>
+
+/*
+ * Blocking FIFO with a fixed capacity linking two pipeline stages.
+ * Producer closes the queue when done, consumer drains what is left.
+ * Closing also unblocks a producer when the consumer gives up.
+ */
+template<typename T>
+class BoundedQueue
+{
+private:
+    QMutex _mutex;
+    QWaitCondition _not_empty;
+    QWaitCondition _not_full;
+    QQueue<T> _queue;
+    int _capacity;
+    bool _closed;
+public:
+    virtual ~BoundedQueue() {}
+    BoundedQueue(int capacity) :
+        _queue(), _capacity(capacity), _closed(false)
+    {}
+
+    bool push(const T &item)
+    {
+        QMutexLocker locker(&_mutex);
+        while (!_closed&&_queue.size()>=_capacity) {
+            _not_full.wait(&_mutex);
+        }
+        if (_closed) {
+            return false;
+        }
+        _queue.enqueue(item);
+        _not_empty.wakeOne();
+        return true;
+    }
+
+    bool pop(T *item)
+    {
+        QMutexLocker locker(&_mutex);
+        while (!_closed&&_queue.isEmpty()) {
+            _not_empty.wait(&_mutex);
+        }
+        if (_queue.isEmpty()) {
+            return false;
+        }
+        (*item)=_queue.dequeue();
+        _not_full.wakeOne();
+        return true;
+    }
+
+    void close()
+    {
+        QMutexLocker locker(&_mutex);
+        _closed=true;
+        _not_empty.wakeAll();
+        _not_full.wakeAll();
+    }
+};
+
+#endif // BOUNDEDQUEUE_H
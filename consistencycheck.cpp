@@ -0,0 +1,203 @@
+#include "consistencycheck.h"
+#include "entrelacwriter.h"
+#include "entrelacgenerator.h"
+#include "entrelacbinary.h"
+#include "symmetry.h"
+
+#include <QTextStream>
+#include <QMultiHash>
+#include <QBuffer>
+
+class EntrelacCollector : public EntrelacSink
+{
+public:
+    QList<Entrelac> entrelacs;
+
+    virtual bool consume(const Entrelac &entrelac)
+    {
+        entrelacs.append(entrelac);
+        return true;
+    }
+};
+
+ConsistencyCheck::~ConsistencyCheck()
+{
+
+}
+
+ConsistencyCheck::ConsistencyCheck(QTextStream *report) :
+    _report(report),
+    _tolerance(0)
+{
+
+}
+
+bool ConsistencyCheck::run(const Graph &graph,
+                           const QList<Entrelac> *reference)
+{
+    QList<Entrelac> expected, lazy;
+    EntrelacCollector sink;
+    Entrelac entrelac((QPointF()));
+    qreal extent=0;
+    bool ok=true;
+    /* tolerance follows the magnitude of coordinates */
+    foreach (const Node *n, graph.nodes()) {
+        extent=qMax(extent, qMax(qAbs(n->position().x()),
+                                 qAbs(n->position().y())));
+    }
+    _tolerance=CONSISTENCY_CHECK_EPSILON*qMax(extent, qreal(1));
+    expected=graph.entrelacs();
+    (*_report) << "coordinates: " << STORED_COORD_NAME << endl;
+    (*_report) << "plain: " << expected.size() << " strands" << endl;
+    if (reference!=nullptr) {
+        ok&=compare("reference", *reference, expected);
+    }
+    Entrelac::generate_from(graph, &sink);
+    ok&=compare("sink", expected, sink.entrelacs);
+    ok&=compare("symmetric", expected,
+                graph.entrelacs(Symmetry::detect(graph)));
+    EntrelacGenerator generator(graph);
+    while (generator.next(&entrelac)) {
+        lazy.append(entrelac);
+    }
+    ok&=compare("lazy", expected, lazy);
+    ok&=round_trip(expected);
+    return ok;
+}
+
+bool ConsistencyCheck::compare(const char *name,
+                               const QList<Entrelac> &expected,
+                               const QList<Entrelac> &actual)
+{
+    QMultiHash<int, QVector<QPointF> > candidates;
+    QMultiHash<int, QVector<QPointF> >::iterator it;
+    QVector<QPointF> pts;
+    int missing=0;
+    /* candidates bucketed by curve count */
+    foreach (const Entrelac &e, actual) {
+        candidates.insert(e.subcurves().size(), points(e));
+    }
+    foreach (const Entrelac &e, expected) {
+        pts=points(e);
+        for (it=candidates.find(e.subcurves().size());
+             it!=candidates.end()&&it.key()==e.subcurves().size(); ++it) {
+            if (same(pts, it.value())) {
+                break;
+            }
+        }
+        if (it!=candidates.end()&&it.key()==e.subcurves().size()) {
+            candidates.erase(it);
+        } else {
+            missing++;
+        }
+    }
+    (*_report) << name << ": " << actual.size() << " strands";
+    if (missing==0&&candidates.isEmpty()) {
+        (*_report) << ", ok" << endl;
+        return true;
+    }
+    (*_report) << ", " << missing << " missing, " << candidates.size()
+               << " unexpected" << endl;
+    return false;
+}
+
+bool ConsistencyCheck::round_trip(const QList<Entrelac> &entrelacs)
+{
+    QBuffer buffer;
+    QList<Entrelac> read;
+    QVector<QPointF> written, pts;
+    QRectF bounds=EntrelacBinaryWriter::bounds(entrelacs);
+    qreal slack, dx, dy;
+    int mismatched=0;
+    bool ok;
+    buffer.open(QBuffer::ReadWrite);
+    EntrelacBinaryWriter writer(&buffer, bounds);
+    foreach (const Entrelac &e, entrelacs) {
+        writer.consume(e);
+    }
+    buffer.seek(0);
+    ok=EntrelacBinaryReader::read(&buffer, &read)&&
+            read.size()==entrelacs.size();
+    /* one quantum per axis, plus the precision of stored points */
+    slack=STORED_POINT_EPSILON*qMax(qMax(qAbs(bounds.left()),
+                                         qAbs(bounds.right())),
+                                    qMax(qAbs(bounds.top()),
+                                         qAbs(bounds.bottom())));
+    dx=bounds.width()/QUANTIZED_MAX+slack;
+    dy=bounds.height()/QUANTIZED_MAX+slack;
+    for (int i=0; ok&&i<entrelacs.size(); ++i) {
+        written=points(entrelacs.at(i));
+        pts=points(read.at(i));
+        if (written.size()!=pts.size()) {
+            mismatched++;
+            continue;
+        }
+        for (int j=0; j<pts.size(); ++j) {
+            if (qAbs(written.at(j).x()-pts.at(j).x())>dx||
+                qAbs(written.at(j).y()-pts.at(j).y())>dy) {
+                mismatched++;
+                break;
+            }
+        }
+    }
+    (*_report) << "binary: " << read.size() << " strands";
+    if (ok&&mismatched==0) {
+        (*_report) << ", ok" << endl;
+        return true;
+    }
+    (*_report) << ", " << (ok? mismatched: entrelacs.size())
+               << " off by more than a quantum" << endl;
+    return false;
+}
+
+bool ConsistencyCheck::same(const QVector<QPointF> &a,
+                            const QVector<QPointF> &b) const
+{
+    int n=a.size();
+    bool fwd, bwd;
+    if (n!=b.size()) {
+        return false;
+    }
+    if (n<=1||!near(a.first(), a.last())||!near(b.first(), b.last())) {
+        /* open strands: same ends, either way */
+        fwd=bwd=true;
+        for (int i=0; i<n&&(fwd||bwd); ++i) {
+            fwd=fwd&&near(a.at(i), b.at(i));
+            bwd=bwd&&near(a.at(i), b.at(n-1-i));
+        }
+        return fwd||bwd;
+    }
+    /* closed strands: any start point, either way, the last point
+     * repeats the first one */
+    n--;
+    for (int s=0; s<n; s+=3) {
+        fwd=bwd=true;
+        for (int i=0; i<n&&(fwd||bwd); ++i) {
+            fwd=fwd&&near(a.at(i), b.at((s+i)%n));
+            bwd=bwd&&near(a.at(i), b.at((s+n-i)%n));
+        }
+        if (fwd||bwd) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool ConsistencyCheck::near(const QPointF &a, const QPointF &b) const
+{
+    return (qAbs(a.x()-b.x())<=_tolerance&&qAbs(a.y()-b.y())<=_tolerance);
+}
+
+QVector<QPointF> ConsistencyCheck::points(const Entrelac &entrelac)
+{
+    QVector<QPointF> pts;
+    CubicCurveList subcurves=entrelac.subcurves();
+    pts.reserve(1+3*subcurves.size());
+    pts.append(entrelac.start());
+    foreach (const CubicCurve &cc, subcurves) {
+        pts.append(cc.src_ctl_pt());
+        pts.append(cc.dst_ctl_pt());
+        pts.append(cc.dst_pt());
+    }
+    return pts;
+}
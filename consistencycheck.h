@@ -0,0 +1,43 @@
+#ifndef CONSISTENCYCHECK_H
+#define CONSISTENCYCHECK_H
+
+#include <QVector>
+#include "graph.h"
+
+class QTextStream; /* pre-decl */
+
+/* relative to the graph extent, loose enough for compact coordinates */
+#define CONSISTENCY_CHECK_EPSILON 1e-5
+
+/*
+ * Checks that every generation path yields the strands of
+ * Graph::entrelacs(): sink, symmetric and lazy generation. When
+ * reference strands are given, Graph::entrelacs() must yield them too,
+ * which pins the output of the tracer across changes.
+ * Strands are compared as closed curves, whatever their start and
+ * direction, and in any order. The binary export is also read back,
+ * its points must be within one quantum of the written ones. One
+ * report line is written per path.
+ */
+class ConsistencyCheck
+{
+private:
+    QTextStream *_report;
+    qreal _tolerance;
+public:
+    virtual ~ConsistencyCheck();
+    ConsistencyCheck(QTextStream *report);
+
+    bool run(const Graph &graph,
+             const QList<Entrelac> *reference=nullptr);
+
+private:
+    bool compare(const char *name, const QList<Entrelac> &expected,
+                 const QList<Entrelac> &actual);
+    bool round_trip(const QList<Entrelac> &entrelacs);
+    bool same(const QVector<QPointF> &a, const QVector<QPointF> &b) const;
+    bool near(const QPointF &a, const QPointF &b) const;
+    static QVector<QPointF> points(const Entrelac &entrelac);
+};
+
+#endif // CONSISTENCYCHECK_H
@@ -0,0 +1,101 @@
+#ifndef COORDS_H
+#define COORDS_H
+
+#include <QPointF>
+#include <QRectF>
+#include <cfloat>
+#include <cstring>
+
+/*
+ * Storage type of node positions and curve points. Computations are
+ * always done in double, building with CONFIG+=compact_coords stores
+ * coordinates as float, halving CubicCurve and Node position sizes.
+ * STORED_POINT_EPSILON is the relative precision of stored coordinates.
+ * STORED_COORD_NAME names the storage type in reports.
+ */
+#ifdef ENTRELACS_COMPACT_COORDS
+class StoredPoint
+{
+private:
+    float _x;
+    float _y;
+public:
+    StoredPoint() :
+        _x(0.f), _y(0.f)
+    {}
+    StoredPoint(const QPointF &pt) :
+        _x(float(pt.x())), _y(float(pt.y()))
+    {}
+    inline operator QPointF() const
+    { return QPointF(_x, _y); }
+};
+Q_DECLARE_TYPEINFO(StoredPoint, Q_PRIMITIVE_TYPE);
+#define STORED_POINT_EPSILON FLT_EPSILON
+#define STORED_COORD_NAME "float"
+#else
+typedef QPointF StoredPoint;
+#define STORED_POINT_EPSILON DBL_EPSILON
+#define STORED_COORD_NAME "double"
+#endif
+
+/* splitmix64 finalizer */
+static inline quint64 hash_mix(quint64 x)
+{
+    x^=x>>30; x*=Q_UINT64_C(0xbf58476d1ce4e5b9);
+    x^=x>>27; x*=Q_UINT64_C(0x94d049bb133111eb);
+    x^=x>>31;
+    return x;
+}
+
+/* hash of the exact coordinates of a point */
+static inline quint64 point_hash(const QPointF &pt)
+{
+    quint64 x, y;
+    double px=pt.x(), py=pt.y();
+    std::memcpy(&x, &px, sizeof(x));
+    std::memcpy(&y, &py, sizeof(y));
+    return hash_mix(x^hash_mix(y));
+}
+
+#define QUANTIZED_MAX 0xffffffffu
+
+/*
+ * 32-bit fixed point coordinates relative to a bounding box, points
+ * outside of it are clamped.
+ */
+class QuantizedFrame
+{
+private:
+    QRectF _bounds;
+public:
+    QuantizedFrame(const QRectF &bounds) :
+        _bounds(bounds)
+    {}
+    inline QRectF bounds() const
+    { return _bounds; }
+
+    inline quint32 quantize_x(qreal x) const
+    { return quantize(x, _bounds.left(), _bounds.width()); }
+    inline quint32 quantize_y(qreal y) const
+    { return quantize(y, _bounds.top(), _bounds.height()); }
+    inline QPointF dequantize(quint32 x, quint32 y) const
+    {
+        return QPointF(_bounds.left()+_bounds.width()*(x/qreal(QUANTIZED_MAX)),
+                       _bounds.top()+_bounds.height()*(y/qreal(QUANTIZED_MAX)));
+    }
+
+private:
+    static inline quint32 quantize(qreal v, qreal min, qreal extent)
+    {
+        qreal r=(extent>0? (v-min)/extent: 0.);
+        if (r<=0) {
+            return 0;
+        }
+        if (r>=1) {
+            return QUANTIZED_MAX;
+        }
+        return quint32(qRound64(r*QUANTIZED_MAX));
+    }
+};
+
+#endif // COORDS_H
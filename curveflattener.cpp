@@ -0,0 +1,233 @@
+#include "curveflattener.h"
+
+#include <QtConcurrent>
+#include <QtMath>
+#include <limits>
+
+struct FlattenJob
+{
+    const Entrelac *entrelac;
+    QPolygonF polyline;
+};
+
+static qreal norm(const QPointF &v)
+{
+    return qSqrt(QPointF::dotProduct(v, v));
+}
+
+int CurveFlattener::segments(const QPointF &p0, const QPointF &p1,
+                             const QPointF &p2, const QPointF &p3,
+                             qreal tolerance)
+{
+    /* Wang's formula, degree 3: n = sqrt(3/4 * L / tolerance) */
+    qreal l=qMax(norm(p0-2*p1+p2), norm(p1-2*p2+p3));
+    int n=qCeil(qSqrt(0.75*l/tolerance));
+    return qBound(1, n, FLATTENER_MAX_SEGMENTS);
+}
+
+QPolygonF CurveFlattener::flatten(const Entrelac &entrelac, qreal tolerance)
+{
+    QPolygonF polyline;
+    QPointF p0=entrelac.start();
+    polyline.reserve(entrelac.subcurves().size()*8+1);
+    polyline.append(p0);
+    foreach (const CubicCurve &cc, entrelac.subcurves()) {
+        flatten_cubic(p0, cc.src_ctl_pt(), cc.dst_ctl_pt(), cc.dst_pt(),
+                      segments(p0, cc.src_ctl_pt(), cc.dst_ctl_pt(),
+                               cc.dst_pt(), tolerance),
+                      &polyline);
+        p0=cc.dst_pt();
+    }
+    return polyline;
+}
+
+QList<QPolygonF> CurveFlattener::flatten(const QList<Entrelac> &entrelacs,
+                                         qreal tolerance)
+{
+    QVector<FlattenJob> jobs;
+    QList<QPolygonF> polylines;
+    jobs.reserve(entrelacs.size());
+    for (int i=0; i<entrelacs.size(); ++i) {
+        jobs.append(FlattenJob{&entrelacs.at(i), QPolygonF()});
+    }
+    QtConcurrent::blockingMap(jobs, [tolerance](FlattenJob &job) {
+        job.polyline=flatten(*job.entrelac, tolerance);
+    });
+    polylines.reserve(jobs.size());
+    foreach (const FlattenJob &job, jobs) {
+        polylines.append(job.polyline);
+    }
+    return polylines;
+}
+
+qreal CurveFlattener::distance(const QPolygonF &polyline, const QPointF &pt)
+{
+    qreal d, min_d=std::numeric_limits<qreal>::max();
+    QPointF ab, ap;
+    qreal t;
+    for (int i=1; i<polyline.size(); ++i) {
+        ab=polyline.at(i)-polyline.at(i-1);
+        ap=pt-polyline.at(i-1);
+        t=QPointF::dotProduct(ab, ab);
+        t=(t>0? qBound(0., QPointF::dotProduct(ap, ab)/t, 1.): 0.);
+        d=norm(ap-t*ab);
+        if (d<min_d) {
+            min_d=d;
+        }
+    }
+    return min_d;
+}
+
+void CurveFlattener::flatten_cubic(const QPointF &p0, const QPointF &p1,
+                                   const QPointF &p2, const QPointF &p3,
+                                   int n, QPolygonF *out)
+{
+    /* power basis: p(t) = ((a*t + b)*t + c)*t + p0 */
+    const qreal ax=p3.x()-3*p2.x()+3*p1.x()-p0.x();
+    const qreal ay=p3.y()-3*p2.y()+3*p1.y()-p0.y();
+    const qreal bx=3*(p2.x()-2*p1.x()+p0.x());
+    const qreal by=3*(p2.y()-2*p1.y()+p0.y());
+    const qreal cx=3*(p1.x()-p0.x());
+    const qreal cy=3*(p1.y()-p0.y());
+    const qreal dt=1./n;
+    int first=out->size();
+    out->resize(first+n);
+    QPointF *pts=out->data()+first;
+    /* iterations are independent, the compiler can vectorize them */
+    for (int i=1; i<n; ++i) {
+        const qreal t=i*dt;
+        pts[i-1]=QPointF(((ax*t+bx)*t+cx)*t+p0.x(),
+                         ((ay*t+by)*t+cy)*t+p0.y());
+    }
+    /* exact end point, no accumulated rounding */
+    pts[n-1]=p3;
+}
+
+FlatteningCache::~FlatteningCache()
+{
+
+}
+
+FlatteningCache::FlatteningCache(qreal tolerance) :
+    _strands(),
+    _order(),
+    _level(std::numeric_limits<int>::min()),
+    _tolerance(tolerance)
+{
+
+}
+
+void FlatteningCache::set_entrelacs(const QList<Entrelac> &entrelacs)
+{
+    QHash<quint64, FlattenedStrand> strands;
+    QHash<quint64, FlattenedStrand>::const_iterator it;
+    quint64 key;
+    strands.reserve(entrelacs.size());
+    _order.clear();
+    _order.reserve(entrelacs.size());
+    /* unchanged strands keep their polylines */
+    foreach (const Entrelac &e, entrelacs) {
+        key=signature(e);
+        _order.append(key);
+        if (strands.contains(key)) {
+            continue;
+        }
+        it=_strands.constFind(key);
+        strands.insert(key, (it!=_strands.constEnd()?
+                                 it.value(): FlattenedStrand(e)));
+    }
+    _strands.swap(strands);
+}
+
+void FlatteningCache::clear()
+{
+    _strands.clear();
+    _order.clear();
+}
+
+int FlatteningCache::level(qreal scale)
+{
+    return qCeil(std::log2(qMax(scale, 1e-6)));
+}
+
+quint64 FlatteningCache::signature(const Entrelac &entrelac)
+{
+    quint64 sig=entrelac.subcurves().size();
+    QPointF prev=entrelac.start();
+    /* order independent sum of curve hashes, each curve hash being
+     * symmetric so that a reversed strand has the same signature */
+    foreach (const CubicCurve &cc, entrelac.subcurves()) {
+        sig+=hash_mix((point_hash(prev)+point_hash(cc.dst_pt()))^
+                      hash_mix(point_hash(cc.src_ctl_pt())+
+                               point_hash(cc.dst_ctl_pt())));
+        prev=cc.dst_pt();
+    }
+    return sig;
+}
+
+QList<QPolygonF> FlatteningCache::polylines(qreal scale)
+{
+    QHash<quint64, FlattenedStrand>::iterator it;
+    QList<Entrelac> missing;
+    QVector<FlattenedStrand*> targets;
+    QList<QPolygonF> flattened, lines;
+    int lvl=level(scale);
+    if (lvl!=_level) {
+        evict(lvl);
+        _level=lvl;
+    }
+    for (it=_strands.begin(); it!=_strands.end(); ++it) {
+        if (!it.value().levels.contains(lvl)) {
+            missing.append(it.value().entrelac);
+            targets.append(&it.value());
+        }
+    }
+    if (!missing.isEmpty()) {
+        /* tolerance in scene units for the finest scale of the level */
+        flattened=CurveFlattener::flatten(missing, _tolerance/qPow(2, lvl));
+        for (int i=0; i<targets.size(); ++i) {
+            targets.at(i)->levels.insert(lvl, flattened.at(i));
+        }
+    }
+    lines.reserve(_order.size());
+    foreach (quint64 key, _order) {
+        lines.append(_strands.constFind(key).value().levels.value(lvl));
+    }
+    return lines;
+}
+
+int FlatteningCache::strand_at(const QPointF &pt, qreal radius, qreal scale)
+{
+    QList<QPolygonF> lines=polylines(scale);
+    int closest=-1;
+    qreal d, min_d=radius;
+    for (int i=0; i<lines.size(); ++i) {
+        if (!lines.at(i).boundingRect().adjusted(-radius, -radius,
+                                                 radius, radius)
+                .contains(pt)) {
+            continue;
+        }
+        if ((d=CurveFlattener::distance(lines.at(i), pt))<=min_d) {
+            min_d=d;
+            closest=i;
+        }
+    }
+    return closest;
+}
+
+void FlatteningCache::evict(int level)
+{
+    QHash<quint64, FlattenedStrand>::iterator it;
+    QHash<int, QPolygonF>::iterator lit;
+    /* far levels are flattened again if ever needed */
+    for (it=_strands.begin(); it!=_strands.end(); ++it) {
+        lit=it.value().levels.begin();
+        while (lit!=it.value().levels.end()) {
+            if (qAbs(lit.key()-level)>FLATTENER_KEPT_LEVELS) {
+                lit=it.value().levels.erase(lit);
+            } else {
+                ++lit;
+            }
+        }
+    }
+}
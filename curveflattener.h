@@ -0,0 +1,78 @@
+#ifndef CURVEFLATTENER_H
+#define CURVEFLATTENER_H
+
+#include <QPolygonF>
+#include <QHash>
+#include <QList>
+#include <QVector>
+#include "graph.h"
+
+#define FLATTENER_TOLERANCE 0.25    /* max. deviation in device pixels */
+#define FLATTENER_MAX_SEGMENTS 256  /* per cubic */
+#define FLATTENER_KEPT_LEVELS 1     /* kept on each side of current level */
+
+/*
+ * Converts strands to polylines deviating at most tolerance from their
+ * cubic curves. The segment count of each cubic comes from the bound
+ * on its second differences (Wang's formula), points are then
+ * evaluated in branch-free loops over the curve parameter.
+ */
+class CurveFlattener
+{
+public:
+    static int segments(const QPointF &p0, const QPointF &p1,
+                        const QPointF &p2, const QPointF &p3,
+                        qreal tolerance);
+    static QPolygonF flatten(const Entrelac &entrelac, qreal tolerance);
+    static QList<QPolygonF> flatten(const QList<Entrelac> &entrelacs,
+                                    qreal tolerance);
+    static qreal distance(const QPolygonF &polyline, const QPointF &pt);
+
+private:
+    static void flatten_cubic(const QPointF &p0, const QPointF &p1,
+                              const QPointF &p2, const QPointF &p3,
+                              int n, QPolygonF *out);
+};
+
+/* strand with its polylines per zoom level */
+struct FlattenedStrand
+{
+    Entrelac entrelac;
+    QHash<int, QPolygonF> levels;
+
+    FlattenedStrand(const Entrelac &e=Entrelac(QPointF())) :
+        entrelac(e), levels()
+    {}
+};
+
+/*
+ * Flattened strands shared by rendering and geometric queries. Strands
+ * are cached on their geometric signature, so a new result only
+ * flattens the strands that changed. Polylines are kept per zoom level
+ * (power of two of the view scale), for the current level and its
+ * neighbours only.
+ */
+class FlatteningCache
+{
+private:
+    QHash<quint64, FlattenedStrand> _strands;
+    QVector<quint64> _order;
+    int _level;
+    qreal _tolerance;
+public:
+    virtual ~FlatteningCache();
+    FlatteningCache(qreal tolerance=FLATTENER_TOLERANCE);
+
+    void set_entrelacs(const QList<Entrelac> &entrelacs);
+    void clear();
+
+    static int level(qreal scale);
+    static quint64 signature(const Entrelac &entrelac);
+    QList<QPolygonF> polylines(qreal scale);
+    int strand_at(const QPointF &pt, qreal radius, qreal scale);
+
+private:
+    void evict(int level);
+};
+
+#endif // CURVEFLATTENER_H
@@ -0,0 +1,98 @@
+#include "entrelacbinary.h"
+
+#include <QIODevice>
+
+static inline void extend(const QPointF &pt, qreal *x0, qreal *y0,
+                          qreal *x1, qreal *y1)
+{
+    (*x0)=qMin(*x0, pt.x()); (*x1)=qMax(*x1, pt.x());
+    (*y0)=qMin(*y0, pt.y()); (*y1)=qMax(*y1, pt.y());
+}
+
+EntrelacBinaryWriter::~EntrelacBinaryWriter()
+{
+
+}
+
+EntrelacBinaryWriter::EntrelacBinaryWriter(QIODevice *device,
+                                           const QRectF &bounds) :
+    _output(device),
+    _frame(bounds)
+{
+    _output.setVersion(QDataStream::Qt_5_0);
+    _output << quint32(ENTRELAC_BINARY_MAGIC)
+            << quint16(ENTRELAC_BINARY_VERSION)
+            << bounds.x() << bounds.y() << bounds.width() << bounds.height();
+}
+
+bool EntrelacBinaryWriter::consume(const Entrelac &entrelac)
+{
+    CubicCurveList subcurves=entrelac.subcurves();
+    _output << quint32(subcurves.size());
+    write_point(entrelac.start());
+    foreach (const CubicCurve &cc, subcurves) {
+        write_point(cc.src_ctl_pt());
+        write_point(cc.dst_ctl_pt());
+        write_point(cc.dst_pt());
+    }
+    return (_output.status()==QDataStream::Ok);
+}
+
+QRectF EntrelacBinaryWriter::bounds(const QList<Entrelac> &entrelacs)
+{
+    QRectF rect;
+    qreal x0=0, y0=0, x1=0, y1=0;
+    bool first=true;
+    /* control points included, curves lie in their convex hull */
+    foreach (const Entrelac &e, entrelacs) {
+        if (first) {
+            x0=x1=e.start().x();
+            y0=y1=e.start().y();
+            first=false;
+        }
+        extend(e.start(), &x0, &y0, &x1, &y1);
+        foreach (const CubicCurve &cc, e.subcurves()) {
+            extend(cc.src_ctl_pt(), &x0, &y0, &x1, &y1);
+            extend(cc.dst_ctl_pt(), &x0, &y0, &x1, &y1);
+            extend(cc.dst_pt(), &x0, &y0, &x1, &y1);
+        }
+    }
+    rect.setCoords(x0, y0, x1, y1);
+    return rect;
+}
+
+void EntrelacBinaryWriter::write_point(const QPointF &pt)
+{
+    _output << _frame.quantize_x(pt.x()) << _frame.quantize_y(pt.y());
+}
+
+bool EntrelacBinaryReader::read(QIODevice *device,
+                                QList<Entrelac> *entrelacs)
+{
+    QDataStream input(device);
+    quint32 magic, count, x, y, sx, sy, dx, dy, px, py;
+    quint16 version;
+    qreal bx, by, bw, bh;
+    input.setVersion(QDataStream::Qt_5_0);
+    input >> magic >> version >> bx >> by >> bw >> bh;
+    if (input.status()!=QDataStream::Ok||magic!=ENTRELAC_BINARY_MAGIC||
+        version!=ENTRELAC_BINARY_VERSION) {
+        return false;
+    }
+    QuantizedFrame frame(QRectF(bx, by, bw, bh));
+    while (!input.atEnd()) {
+        input >> count >> x >> y;
+        Entrelac entrelac(frame.dequantize(x, y));
+        for (quint32 i=0; i<count&&input.status()==QDataStream::Ok; ++i) {
+            input >> sx >> sy >> dx >> dy >> px >> py;
+            entrelac.add_subcurve(CubicCurve(frame.dequantize(sx, sy),
+                                             frame.dequantize(dx, dy),
+                                             frame.dequantize(px, py)));
+        }
+        if (input.status()!=QDataStream::Ok) {
+            return false;
+        }
+        entrelacs->append(entrelac);
+    }
+    return true;
+}
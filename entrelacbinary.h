@@ -0,0 +1,42 @@
+#ifndef ENTRELACBINARY_H
+#define ENTRELACBINARY_H
+
+#include <QDataStream>
+#include "entrelacwriter.h"
+#include "coords.h"
+
+class QIODevice; /* pre-decl */
+
+#define ENTRELAC_BINARY_MAGIC 0x454e5442u  /* "ENTB" */
+#define ENTRELAC_BINARY_VERSION 1
+
+/*
+ * Compact binary entrelacs format, coordinates are 32-bit fixed point
+ * relative to the bounding box stored in the header:
+ *   magic, version, bounds (x, y, w, h as doubles)
+ *   per entrelac: curve count, start, curves (scp, dcp, dp)
+ */
+class EntrelacBinaryWriter : public EntrelacSink
+{
+private:
+    QDataStream _output;
+    QuantizedFrame _frame;
+public:
+    virtual ~EntrelacBinaryWriter();
+    EntrelacBinaryWriter(QIODevice *device, const QRectF &bounds);
+
+    virtual bool consume(const Entrelac &entrelac);
+
+    static QRectF bounds(const QList<Entrelac> &entrelacs);
+
+private:
+    void write_point(const QPointF &pt);
+};
+
+class EntrelacBinaryReader
+{
+public:
+    static bool read(QIODevice *device, QList<Entrelac> *entrelacs);
+};
+
+#endif // ENTRELACBINARY_H
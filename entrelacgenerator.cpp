@@ -0,0 +1,102 @@
+#include "entrelacgenerator.h"
+#include "entrelacpolicy.h"
+
+/* one strand with the tracer of the generator style */
+struct StrandJob
+{
+    EntrelacGenerator *generator;
+    const Arc *arc;             /* null for the next strand */
+    Entrelac *entrelac;
+    bool found;
+
+    template<class Tracer>
+    void run()
+    {
+        found=(arc==nullptr? Tracer::next(generator, entrelac):
+                             Tracer::through(generator, arc, entrelac));
+    }
+};
+
+EntrelacGenerator::~EntrelacGenerator()
+{
+
+}
+
+EntrelacGenerator::EntrelacGenerator(const Graph &graph,
+                                     const QRectF &viewport,
+                                     EntrelacStyle style) :
+    _graph(&graph),
+    _viewport(viewport),
+    _style(style),
+    _cursor(graph._arcs.constBegin()),
+    _used()
+{
+
+}
+
+bool EntrelacGenerator::next(Entrelac *entrelac)
+{
+    StrandJob job={this, nullptr, entrelac, false};
+    /* dead ends are dropped by the tracer, which keeps looking */
+    run_with_style(_style, &job);
+    return job.found;
+}
+
+bool EntrelacGenerator::through(const Arc *arc, Entrelac *entrelac)
+{
+    StrandJob job={this, arc, entrelac, false};
+    if (arc==nullptr) {
+        return false;
+    }
+    run_with_style(_style, &job);
+    return job.found;
+}
+
+void EntrelacGenerator::reset()
+{
+    _cursor=_graph->_arcs.constBegin();
+    _used.clear();
+}
+
+const Arc *EntrelacGenerator::first()
+{
+    /* skip exhausted arcs and arcs outside viewport */
+    while (_cursor!=_graph->_arcs.constEnd()&&
+           (pending(_cursor.value())==0||!inside(_cursor.value()))) {
+        ++_cursor;
+    }
+    if (_cursor==_graph->_arcs.constEnd()) {
+        return nullptr;
+    }
+    return _cursor.value();
+}
+
+ushort EntrelacGenerator::pending(const Arc *a) const
+{
+    return ALL_PASSAGES&~_used.value(a, 0);
+}
+
+bool EntrelacGenerator::take(const Arc *a, ushort passages)
+{
+    ushort &used=_used[a];
+    if ((used&passages)!=0) {
+        return false;
+    }
+    used|=passages;
+    return true;
+}
+
+void EntrelacGenerator::drop(const Arc *a)
+{
+    _used.insert(a, ALL_PASSAGES);
+}
+
+bool EntrelacGenerator::inside(const Arc *a) const
+{
+    if (_viewport.isNull()) {
+        return true;
+    }
+    return _viewport.contains(
+                Entrelac::midpoint(a->const_src()->position(),
+                                   a->const_dst()->position()));
+}
@@ -0,0 +1,40 @@
+#ifndef ENTRELACGENERATOR_H
+#define ENTRELACGENERATOR_H
+
+#include <QRectF>
+#include "graph.h"
+
+/*
+ * Pull based entrelacs generation: each strand is traced only when
+ * asked for, so consumers may stop early. Passages used by strands
+ * already yielded are tracked lazily, nothing is precomputed. The graph
+ * must not be modified while a generator is in use.
+ */
+class EntrelacGenerator
+{
+private:
+    const Graph *_graph;
+    QRectF _viewport;
+    EntrelacStyle _style;
+    ArcHash::const_iterator _cursor;
+    PendingPassageTable _used;
+public:
+    virtual ~EntrelacGenerator();
+    EntrelacGenerator(const Graph &graph, const QRectF &viewport=QRectF(),
+                      EntrelacStyle style=WEAVE_STYLE);
+
+    bool next(Entrelac *entrelac);
+    bool through(const Arc *arc, Entrelac *entrelac);
+    void reset();
+
+    /* passage accounting used by the tracer */
+    const Arc *first();
+    ushort pending(const Arc *a) const;
+    bool take(const Arc *a, ushort passages);
+    void drop(const Arc *a);
+
+private:
+    bool inside(const Arc *a) const;
+};
+
+#endif // ENTRELACGENERATOR_H
@@ -0,0 +1,495 @@
+#ifndef ENTRELACPOLICY_H
+#define ENTRELACPOLICY_H
+
+#include <QtMath>
+#include <QList>
+#include <QPointF>
+#include <QPair>
+#include "graph.h"
+#include "symmetry.h"
+
+/*
+ * Compile-time policies for strand tracing. The direction is a template
+ * parameter of each step so that next_arc is specialised per direction
+ * and curve shapes are inlined in the tracing loop.
+ */
+
+/* ---------- direction alternation policies ---------- */
+
+template<RotationDirection DIR>
+struct OppositeDirection
+{
+    static const RotationDirection value=
+            (DIR==CLOCKWISE_DIRECTION?
+                 COUNTERCLOCKWISE_DIRECTION: CLOCKWISE_DIRECTION);
+};
+
+/* over/under weaving: direction flips at every node */
+struct AlternatingDirection
+{
+    template<RotationDirection DIR>
+    struct next
+    {
+        static const RotationDirection value=OppositeDirection<DIR>::value;
+    };
+};
+
+/* strands keep turning the same way */
+struct ConstantDirection
+{
+    template<RotationDirection DIR>
+    struct next
+    {
+        static const RotationDirection value=DIR;
+    };
+};
+
+/* ---------- scale laws ---------- */
+
+/* normalization [0,PI]->[0,1] and [PI,2*PI]->[1,3] */
+struct PiecewiseLinearScale
+{
+    static inline qreal scale(qreal ang)
+    {
+        if (ang<=M_PI) {
+            return ang/M_PI;
+        }
+        return 1+2*(ang-M_PI)/M_PI;
+    }
+};
+
+/* ---------- curve shape policies ---------- */
+
+/* tangent of a turn in direction DIR around the origin, at v */
+template<RotationDirection DIR>
+static inline QPointF turn_normal(const QPointF &v)
+{
+    if (DIR==CLOCKWISE_DIRECTION) {
+        return QPointF(v.y(), -v.x());
+    }
+    return QPointF(-v.y(), v.x());
+}
+
+static inline CubicCurve straight_curve(const QPointF &src,
+                                        const QPointF &dst)
+{
+    return CubicCurve(src+(dst-src)/3, src+2*(dst-src)/3, dst);
+}
+
+/*
+ * Curve shapes turn around center in the direction of the turn, so that
+ * a strand traced backwards has the same curves.
+ */
+
+/* control points halfway between radial and tangent, scaled by angle */
+template<class ScaleLaw=PiecewiseLinearScale>
+struct AdaptiveBezierCurve
+{
+    template<RotationDirection DIR>
+    static inline void append(Entrelac *entrelac, const QPointF &start_curve,
+                              const QPointF &end_curve,
+                              const QPointF &center, qreal ang)
+    {
+        qreal scale=ScaleLaw::scale(ang);
+        QPointF scp, dcp;
+        scp=center+(start_curve-center+
+                    turn_normal<DIR>(start_curve-center))/2;
+        scp=start_curve+scale*(scp-start_curve);
+        dcp=center+(end_curve-center+
+                    turn_normal<DIR>(center-end_curve))/2;
+        dcp=end_curve+scale*(dcp-end_curve);
+        entrelac->add_subcurve(CubicCurve(scp, dcp, end_curve));
+    }
+};
+
+/* cubic approximation of a circular arc sweeping ang around center */
+struct CircularArcCurve
+{
+    template<RotationDirection DIR>
+    static inline void append(Entrelac *entrelac, const QPointF &start_curve,
+                              const QPointF &end_curve,
+                              const QPointF &center, qreal ang)
+    {
+        qreal k=4./3.*qTan(qMin(ang, 3*M_PI/2)/4);
+        entrelac->add_subcurve(CubicCurve(
+                start_curve+k*turn_normal<DIR>(start_curve-center),
+                end_curve+k*turn_normal<DIR>(center-end_curve),
+                end_curve));
+    }
+};
+
+/* straight segments meeting where the end tangents cross */
+struct StraightCornerCurve
+{
+    template<RotationDirection DIR>
+    static inline void append(Entrelac *entrelac, const QPointF &start_curve,
+                              const QPointF &end_curve,
+                              const QPointF &center, qreal ang)
+    {
+        QPointF ds=turn_normal<DIR>(start_curve-center);
+        QPointF de=turn_normal<DIR>(center-end_curve);
+        QPointF corner;
+        qreal cross=ds.x()*de.y()-ds.y()*de.x();
+        qreal s;
+        Q_UNUSED(ang)
+        if (qFuzzyIsNull(cross)) {
+            entrelac->add_subcurve(straight_curve(start_curve, end_curve));
+            return;
+        }
+        s=((end_curve.x()-start_curve.x())*de.y()-
+           (end_curve.y()-start_curve.y())*de.x())/cross;
+        corner=start_curve+s*ds;
+        entrelac->add_subcurve(straight_curve(start_curve, corner));
+        entrelac->add_subcurve(straight_curve(corner, end_curve));
+    }
+};
+
+/* ---------- passage accounting ---------- */
+
+/*
+ * A strand passes over an arc heading to one of its ends and turns in
+ * some direction there: four passages per arc. Each passage belongs to
+ * exactly one strand, so a strand is traced until its first passage
+ * comes back. Taking a passage also takes the one of the same strand
+ * traced backwards, which keeps strands from being traced twice.
+ */
+#define PASSAGE_TO_DST_CCW 0x1
+#define PASSAGE_TO_DST_CW 0x2
+#define PASSAGE_TO_SRC_CCW 0x4
+#define PASSAGE_TO_SRC_CW 0x8
+#define ALL_PASSAGES 0xf
+
+typedef QList<QPair<const Arc*, ushort> > PassageList;
+
+static inline ushort passage(const Arc *a, const Node *toward,
+                             RotationDirection dir)
+{
+    if (toward==a->const_dst()) {
+        return (dir==COUNTERCLOCKWISE_DIRECTION?
+                    PASSAGE_TO_DST_CCW: PASSAGE_TO_DST_CW);
+    }
+    return (dir==COUNTERCLOCKWISE_DIRECTION?
+                PASSAGE_TO_SRC_CCW: PASSAGE_TO_SRC_CW);
+}
+
+/* same passages seen from an arc with swapped ends */
+static inline ushort swapped_passages(ushort passages)
+{
+    return ushort(((passages&0x3)<<2)|((passages>>2)&0x3));
+}
+
+/*
+ * Pending passage table. Tables used by the tracer all provide:
+ *   const Arc *first()                 arc to start next strand from
+ *   ushort pending(const Arc *a)       free passages of a
+ *   bool take(const Arc *a, ushort p)  use passages p, false if used
+ *   void drop(const Arc *a)            never start from a again
+ */
+class PendingTableAccounting
+{
+private:
+    PendingPassageTable *_pending;
+    PassageList *_visited;
+public:
+    PendingTableAccounting(PendingPassageTable *pending,
+                           PassageList *visited=nullptr) :
+        _pending(pending), _visited(visited)
+    {}
+    static void fill(const Graph &graph, PendingPassageTable *pending)
+    {
+        pending->reserve(graph.arcs().size());
+        foreach (const Arc *a, graph.arcs()) {
+            pending->insert(a, ALL_PASSAGES);
+        }
+    }
+    inline const Arc *first() const
+    { return (_pending->isEmpty()? nullptr: _pending->begin().key()); }
+    inline ushort pending(const Arc *a) const
+    { return _pending->value(a, 0); }
+    inline bool take(const Arc *a, ushort passages)
+    {
+        PendingPassageTable::iterator it=_pending->find(a);
+        if (it==_pending->end()||(it.value()&passages)!=passages) {
+            return false;
+        }
+        it.value()&=~passages;
+        if (it.value()==0) {
+            _pending->erase(it);
+        }
+        if (_visited!=nullptr) {
+            _visited->append(qMakePair(a, passages));
+        }
+        return true;
+    }
+    inline void drop(const Arc *a)
+    { _pending->remove(a); }
+};
+
+/* ---------- tracer ---------- */
+
+struct TraceState
+{
+    Entrelac entrelac;
+    const Arc *start_arc;
+    const Node *start_node;
+    const Node *end_node;
+
+    TraceState(const Arc *arc) :
+        entrelac(Entrelac::midpoint(arc->const_src()->position(),
+                                    arc->const_dst()->position())),
+        start_arc(arc), start_node(arc->const_src()),
+        end_node(arc->const_dst())
+    {}
+};
+
+template<class DirectionPolicy, class CurvePolicy>
+class EntrelacTracer
+{
+public:
+    /* next strand from the free passages of table, false when none is
+     * left, every strand generation goes through here */
+    template<class Table>
+    static bool next(Table *table, Entrelac *entrelac)
+    {
+        const Arc *start_arc;
+        while ((start_arc=table->first())!=nullptr) {
+            if (through(table, start_arc, entrelac)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /* strand over a free passage of start_arc, false if there is none */
+    template<class Table>
+    static bool through(Table *table, const Arc *start_arc,
+                        Entrelac *entrelac)
+    {
+        ushort passages=table->pending(start_arc);
+        if (passages==0) {
+            return false;
+        }
+        /* strands leave toward the arc destination, a passage heading
+         * there is free as long as any passage of the arc is */
+        (*entrelac)=trace(start_arc,
+                          ((passages&PASSAGE_TO_DST_CCW)!=0?
+                               COUNTERCLOCKWISE_DIRECTION:
+                               CLOCKWISE_DIRECTION),
+                          table);
+        if (entrelac->subcurves().isEmpty()) {
+            /* degenerate arc, never pick it again */
+            table->drop(start_arc);
+            return false;
+        }
+        return true;
+    }
+
+    static QList<Entrelac> generate_from(const Graph &graph)
+    {
+        QList<Entrelac> entrelacs;
+        PendingPassageTable pending;
+        PendingTableAccounting table(&pending);
+        Entrelac entrelac((QPointF()));
+        PendingTableAccounting::fill(graph, &pending);
+        while (next(&table, &entrelac)) {
+            entrelacs.append(entrelac);
+        }
+        return entrelacs;
+    }
+
+    /* trace one strand per orbit, rotate it to get the others */
+    static QList<Entrelac> generate_from(const Graph &graph,
+                                         const Symmetry &symmetry)
+    {
+        QList<Entrelac> entrelacs;
+        PendingPassageTable pending;
+        PassageList visited, mapped;
+        PendingTableAccounting table(&pending, &visited), copies(&pending);
+        ArcMap arc_map;
+        QSet<const Arc*> swapped;
+        Entrelac first((QPointF()));
+        if (symmetry.is_trivial()||
+            !symmetry.map_arcs(graph, &arc_map, &swapped)) {
+            return generate_from(graph);
+        }
+        PendingTableAccounting::fill(graph, &pending);
+        while (next(&table, &first)) {
+            entrelacs.append(first);
+            mapped=visited;
+            visited.clear();
+            for (int k=1; k<symmetry.order(); ++k) {
+                for (int i=0; i<mapped.size(); ++i) {
+                    if (swapped.contains(mapped.at(i).first)) {
+                        mapped[i].second=swapped_passages(mapped.at(i).second);
+                    }
+                    mapped[i].first=arc_map.value(mapped.at(i).first);
+                }
+                /* a strand invariant under k steps only has k copies */
+                if (!copies.take(mapped.first().first,
+                                 mapped.first().second)) {
+                    break;
+                }
+                for (int i=1; i<mapped.size(); ++i) {
+                    copies.take(mapped.at(i).first, mapped.at(i).second);
+                }
+                entrelacs.append(Symmetry::map(first, symmetry.transform(k)));
+            }
+        }
+        return entrelacs;
+    }
+
+    /* move state one curve forward around its end node */
+    template<RotationDirection DIR>
+    static inline void step(TraceState *state, const Arc *end_arc,
+                            qreal ang)
+    {
+        QPointF start_curve, end_curve;
+        start_curve=Entrelac::midpoint(state->start_node->position(),
+                                       state->end_node->position());
+        state->start_node=state->end_node;
+        state->end_node=(state->start_node==end_arc->const_src()?
+                             end_arc->const_dst(): end_arc->const_src());
+        end_curve=Entrelac::midpoint(state->start_node->position(),
+                                     state->end_node->position());
+        CurvePolicy::template append<DIR>(&state->entrelac, start_curve,
+                                          end_curve,
+                                          state->start_node->position(),
+                                          ang);
+        state->start_arc=end_arc;
+    }
+
+    /* arc following a_ref around n in direction DIR, ang is the angle
+     * swept from a_ref to it, only relative angles are compared so
+     * that the choice does not depend on the graph orientation */
+    template<RotationDirection DIR>
+    static inline const Arc *next_arc(const Node *n, const Arc *a_ref,
+                                      qreal *ang)
+    {
+        const QList<const Arc*> arcs=n->arcs();
+        const Arc *next_a=a_ref;
+        qreal ang_ref, rel;
+        /* dead end: turn back on the same arc */
+        (*ang)=2*M_PI;
+        if (arcs.size()<=1) {
+            return arcs.first();
+        }
+        ang_ref=angle(n, a_ref);
+        foreach (const Arc *a, arcs) {
+            if (a==a_ref) {
+                continue;
+            }
+            /* angular distance in direction DIR, in ]0,2*PI] */
+            rel=angle(n, a)-ang_ref;
+            if (DIR==CLOCKWISE_DIRECTION) {
+                rel=-rel;
+            }
+            if (rel<=0) {
+                rel+=2*M_PI;
+            }
+            if (rel<(*ang)) {
+                next_a=a;
+                (*ang)=rel;
+            }
+        }
+        return next_a;
+    }
+
+private:
+    /* Table::take refuses the first passage once the strand is closed */
+    template<class Table>
+    static Entrelac trace(const Arc *start_arc, RotationDirection dir,
+                          Table *table)
+    {
+        TraceState state(start_arc);
+        /* direction resolved once, steps are then specialised */
+        if (dir==COUNTERCLOCKWISE_DIRECTION) {
+            loop<COUNTERCLOCKWISE_DIRECTION>(&state, table);
+        } else {
+            loop<CLOCKWISE_DIRECTION>(&state, table);
+        }
+        return state.entrelac;
+    }
+
+    template<RotationDirection DIR, class Table>
+    static void loop(TraceState *state, Table *table)
+    {
+        static const RotationDirection NEXT=
+                DirectionPolicy::template next<DIR>::value;
+        /* policies alternate between two directions at most */
+        Q_STATIC_ASSERT((DirectionPolicy::template next<NEXT>::value==DIR));
+        while (advance<DIR>(state, table)&&advance<NEXT>(state, table)) {
+            /* until the first passage comes back */
+        }
+    }
+
+    template<RotationDirection DIR, class Table>
+    static inline bool advance(TraceState *state, Table *table)
+    {
+        /* backwards, the strand turns the other way at the node behind */
+        static const RotationDirection BACK=OppositeDirection<
+                DirectionPolicy::template next<DIR>::value>::value;
+        const Arc *end_arc;
+        qreal ang;
+        if (!table->take(state->start_arc,
+                         passage(state->start_arc, state->end_node, DIR)|
+                         passage(state->start_arc, state->start_node, BACK))) {
+            return false;
+        }
+        end_arc=next_arc<DIR>(state->end_node, state->start_arc, &ang);
+        step<DIR>(state, end_arc, ang);
+        return true;
+    }
+
+    static inline qreal angle(const Node *n, const Arc *a)
+    {
+        const Node *o=(a->const_src()==n? a->const_dst(): a->const_src());
+        qreal ang=qAtan2(o->position().y()-n->position().y(),
+                         o->position().x()-n->position().x());
+        if (ang<0) {
+            ang=(2*M_PI)+ang;
+        }
+        return ang;
+    }
+};
+
+/* weaving of WEAVE_STYLE, the default style */
+typedef EntrelacTracer<AlternatingDirection, AdaptiveBezierCurve<> >
+        DefaultEntrelacTracer;
+
+/*
+ * Calls job->run<Tracer>() with the tracer of style. Tracers are
+ * specialised at compile time, every generation entry point picks its
+ * tracer here.
+ */
+template<class Job>
+static inline void run_with_style(EntrelacStyle style, Job *job)
+{
+    switch (style) {
+    case ROUND_WEAVE_STYLE:
+        job->template run<EntrelacTracer<AlternatingDirection,
+                                         CircularArcCurve> >();
+        break;
+    case CORNER_WEAVE_STYLE:
+        job->template run<EntrelacTracer<AlternatingDirection,
+                                         StraightCornerCurve> >();
+        break;
+    case COIL_STYLE:
+        job->template run<EntrelacTracer<ConstantDirection,
+                                         AdaptiveBezierCurve<> > >();
+        break;
+    case ROUND_COIL_STYLE:
+        job->template run<EntrelacTracer<ConstantDirection,
+                                         CircularArcCurve> >();
+        break;
+    case CORNER_COIL_STYLE:
+        job->template run<EntrelacTracer<ConstantDirection,
+                                         StraightCornerCurve> >();
+        break;
+    case WEAVE_STYLE:
+    default:
+        job->template run<DefaultEntrelacTracer>();
+        break;
+    }
+}
+
+#endif // ENTRELACPOLICY_H
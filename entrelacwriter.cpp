@@ -0,0 +1,110 @@
+#include "entrelacwriter.h"
+#include "ribbon.h"
+
+#include <QTextStream>
+#include <QStringList>
+
+EntrelacWriter::~EntrelacWriter()
+{
+
+}
+
+EntrelacWriter::EntrelacWriter(QTextStream *output) :
+    _writer(output)
+{
+
+}
+
+bool EntrelacWriter::consume(const Entrelac &entrelac)
+{
+    _writer.append("# ---------- entrelac ----------\n");
+    _writer.append("s=");
+    write_point(entrelac.start());
+    _writer.append('\n');
+    foreach (const CubicCurve &cc, entrelac.subcurves()) {
+        _writer.append("c=");
+        write_point(cc.src_ctl_pt());
+        write_point(cc.dst_ctl_pt());
+        write_point(cc.dst_pt());
+        _writer.append('\n');
+    }
+    return _writer.ok();
+}
+
+bool EntrelacWriter::consume(const Ribbon &ribbon)
+{
+    _writer.append("# ---------- ribbon ----------\n");
+    foreach (const Entrelac &e, ribbon.outline()) {
+        if (!consume(e)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool EntrelacWriter::flush()
+{
+    return _writer.flush();
+}
+
+void EntrelacWriter::write_point(const QPointF &pt)
+{
+    _writer.append('[');
+    _writer.append_real(pt.x());
+    _writer.append(';');
+    _writer.append_real(pt.y());
+    _writer.append(']');
+}
+
+bool EntrelacReader::read(QTextStream *input, QList<Entrelac> *entrelacs)
+{
+    QString line;
+    QPointF pts[3];
+    while ((*input).readLineInto(&line)) {
+        line=line.trimmed();
+        if (line.isEmpty()||line.startsWith('#')) {
+            continue;
+        }
+        if (line.startsWith("s=")) {
+            if (!parse_points(line.mid(2), pts, 1)) {
+                return false;
+            }
+            entrelacs->append(Entrelac(pts[0]));
+        } else if (line.startsWith("c=")&&!entrelacs->isEmpty()) {
+            if (!parse_points(line.mid(2), pts, 3)) {
+                return false;
+            }
+            entrelacs->last().add_subcurve(CubicCurve(pts[0], pts[1], pts[2]));
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool EntrelacReader::parse_points(const QString &data, QPointF *pts,
+                                  int count)
+{
+    QStringList items, coords;
+    bool ok_x, ok_y;
+    /* [x;y][x;y]... */
+    if (!data.startsWith('[')||!data.endsWith(']')) {
+        return false;
+    }
+    items=data.mid(1, data.length()-2).split("][");
+    if (items.size()!=count) {
+        return false;
+    }
+    for (int i=0; i<count; ++i) {
+        coords=items.at(i).split(';');
+        if (coords.size()!=2) {
+            return false;
+        }
+        pts[i]=QPointF(coords.first().toDouble(&ok_x),
+                       coords.last().toDouble(&ok_y));
+        if (!ok_x||!ok_y) {
+            return false;
+        }
+    }
+    return true;
+}
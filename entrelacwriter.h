@@ -0,0 +1,57 @@
+#ifndef ENTRELACWRITER_H
+#define ENTRELACWRITER_H
+
+#include "graph.h"
+#include "blockwriter.h"
+
+class QTextStream;
+class Ribbon; /* pre-decl */
+
+/*
+ * Consumer of generated entrelacs, called once per closed strand.
+ * Returning false stops the generation.
+ */
+class EntrelacSink
+{
+public:
+    virtual ~EntrelacSink() {}
+    virtual bool consume(const Entrelac &entrelac) = 0;
+};
+
+/*
+ * Streams entrelacs to a text stream as they are generated:
+ *   s=[x;y]                    strand start
+ *   c=[x;y][x;y][x;y]          cubic subcurve (scp, dcp, dp)
+ * A ribbon is written as its closed outline curves.
+ */
+class EntrelacWriter : public EntrelacSink
+{
+private:
+    BlockWriter _writer;
+public:
+    virtual ~EntrelacWriter();
+    EntrelacWriter(QTextStream *output);
+
+    virtual bool consume(const Entrelac &entrelac);
+    bool consume(const Ribbon &ribbon);
+
+    bool flush();
+
+private:
+    void write_point(const QPointF &pt);
+};
+
+/*
+ * Reads back the text written by EntrelacWriter, each "s=" line starts
+ * a new strand. Used to compare generated strands with reference files.
+ */
+class EntrelacReader
+{
+public:
+    static bool read(QTextStream *input, QList<Entrelac> *entrelacs);
+
+private:
+    static bool parse_points(const QString &data, QPointF *pts, int count);
+};
+
+#endif // ENTRELACWRITER_H
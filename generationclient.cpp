@@ -0,0 +1,53 @@
+#include "generationclient.h"
+
+#include <QLocalSocket>
+
+GenerationClient::~GenerationClient()
+{
+    delete _socket;
+}
+
+GenerationClient::GenerationClient(int timeout) :
+    _socket(new QLocalSocket),
+    _timeout(timeout)
+{
+
+}
+
+bool GenerationClient::connect(const QString &name)
+{
+    _socket->connectToServer(name);
+    return _socket->waitForConnected(_timeout);
+}
+
+bool GenerationClient::request(const QStringList &requests,
+                               QStringList *responses)
+{
+    QByteArray batch;
+    int expected=0;
+    foreach (const QString &request, requests) {
+        if (!request.trimmed().isEmpty()) {
+            batch+=request.trimmed().toUtf8();
+            batch+='\n';
+            expected++;
+        }
+    }
+    /* send the whole batch at once */
+    _socket->write(batch);
+    while (_socket->bytesToWrite()>0) {
+        if (!_socket->waitForBytesWritten(_timeout)) {
+            return false;
+        }
+    }
+    while (expected>0) {
+        while (expected>0&&_socket->canReadLine()) {
+            responses->append(QString::fromUtf8(_socket->readLine())
+                              .trimmed());
+            expected--;
+        }
+        if (expected>0&&!_socket->waitForReadyRead(_timeout)) {
+            return false;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,27 @@
+#ifndef GENERATIONCLIENT_H
+#define GENERATIONCLIENT_H
+
+#include <QStringList>
+
+#define GENERATION_CLIENT_TIMEOUT 30000
+
+class QLocalSocket; /* pre-decl */
+
+/*
+ * Minimal blocking client of GenerationServer, sends a batch of
+ * requests and waits for one response line per request.
+ */
+class GenerationClient
+{
+private:
+    QLocalSocket *_socket;
+    int _timeout;
+public:
+    virtual ~GenerationClient();
+    GenerationClient(int timeout=GENERATION_CLIENT_TIMEOUT);
+
+    bool connect(const QString &name);
+    bool request(const QStringList &requests, QStringList *responses);
+};
+
+#endif // GENERATIONCLIENT_H
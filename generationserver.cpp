@@ -0,0 +1,324 @@
+#include "generationserver.h"
+#include "entrelacwriter.h"
+#include "ribbon.h"
+#include "entrelacgenerator.h"
+#include "entrelacbinary.h"
+
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <QFutureWatcher>
+#include <QtConcurrent>
+#include <QMutexLocker>
+#include <QFile>
+#include <QTextStream>
+
+#define OK_RESPONSE(content) (QByteArray("ok ")+(content))
+#define ERR_RESPONSE(content) (QByteArray("error ")+(content))
+
+GenerationServer::~GenerationServer()
+{
+    _server->close();
+    _pool.waitForDone();
+}
+
+GenerationServer::GenerationServer(QObject *parent) :
+    QObject(parent),
+    _server(new QLocalServer(this)),
+    _pool(),
+    _sessions_lock(),
+    _sessions(),
+    _clients()
+{
+    connect(_server, &QLocalServer::newConnection,
+            this, &GenerationServer::accept);
+}
+
+bool GenerationServer::listen(const QString &name)
+{
+    /* remove stale socket left by a crashed instance */
+    QLocalServer::removeServer(name);
+    return _server->listen(name);
+}
+
+void GenerationServer::accept()
+{
+    QLocalSocket *socket;
+    GenerationConnection client;
+    while ((socket=_server->nextPendingConnection())!=nullptr) {
+        client.watcher=new QFutureWatcher<QByteArray>(socket);
+        _clients.insert(socket, client);
+        connect(socket, &QLocalSocket::readyRead,
+                this, [this, socket]() { read(socket); });
+        connect(socket, &QLocalSocket::disconnected,
+                this, [this, socket]() {
+            _clients.remove(socket);
+            socket->deleteLater();
+        });
+        connect(client.watcher, &QFutureWatcher<QByteArray>::finished,
+                this, [this, socket]() { finished(socket); });
+    }
+}
+
+void GenerationServer::read(QLocalSocket *socket)
+{
+    QHash<QLocalSocket*, GenerationConnection>::iterator it;
+    it=_clients.find(socket);
+    if (it==_clients.end()) {
+        return;
+    }
+    while (socket->canReadLine()) {
+        it.value().pending.append(QString::fromUtf8(socket->readLine())
+                                  .trimmed());
+    }
+    dispatch(socket);
+}
+
+void GenerationServer::dispatch(QLocalSocket *socket)
+{
+    QHash<QLocalSocket*, GenerationConnection>::iterator it;
+    QStringList requests;
+    it=_clients.find(socket);
+    /* one batch in flight per client keeps responses ordered */
+    if (it==_clients.end()||it.value().pending.isEmpty()||
+        it.value().watcher->isRunning()) {
+        return;
+    }
+    requests=it.value().pending;
+    it.value().pending.clear();
+    it.value().watcher->setFuture(QtConcurrent::run(&_pool,
+                                                    [this, requests]() {
+        return handle_batch(requests);
+    }));
+}
+
+void GenerationServer::finished(QLocalSocket *socket)
+{
+    QHash<QLocalSocket*, GenerationConnection>::iterator it;
+    it=_clients.find(socket);
+    if (it==_clients.end()) {
+        return;
+    }
+    socket->write(it.value().watcher->result());
+    dispatch(socket);
+}
+
+QByteArray GenerationServer::handle_batch(const QStringList &requests)
+{
+    QByteArray responses;
+    foreach (const QString &request, requests) {
+        responses+=handle(request);
+        responses+='\n';
+    }
+    return responses;
+}
+
+QByteArray GenerationServer::handle(const QString &request)
+{
+    QStringList args=request.split(' ', QString::SkipEmptyParts);
+    QString cmd;
+    GenerationSessionPtr s;
+    QFile file;
+    QTextStream stream;
+    QUuid id;
+    qreal x, y;
+    bool okx, oky;
+    if (args.isEmpty()) {
+        return ERR_RESPONSE("empty request");
+    }
+    cmd=args.takeFirst();
+    if (cmd=="ping") {
+        return "ok";
+    }
+    if (args.isEmpty()) {
+        return ERR_RESPONSE("missing session name");
+    }
+    if (cmd=="load") {
+        if (args.size()!=2) {
+            return ERR_RESPONSE("usage: load <session> <path>");
+        }
+        file.setFileName(args.at(1));
+        if (!file.open(QFile::ReadOnly)) {
+            return ERR_RESPONSE("can't open file");
+        }
+        s=GenerationSessionPtr(new GenerationSession);
+        stream.setDevice(&file);
+        if (!s->graph.parse(&stream)) {
+            return ERR_RESPONSE("failed to parse graph");
+        }
+        QMutexLocker locker(&_sessions_lock);
+        _sessions.insert(args.at(0), s);
+        return OK_RESPONSE(QByteArray::number(s->graph.nodes().size())+' '+
+                           QByteArray::number(s->graph.arcs().size()));
+    }
+    if (cmd=="unload") {
+        QMutexLocker locker(&_sessions_lock);
+        if (_sessions.remove(args.at(0))==0) {
+            return ERR_RESPONSE("unknown session");
+        }
+        return "ok";
+    }
+    /* following requests work on a loaded session */
+    if ((s=session(args.at(0))).isNull()) {
+        return ERR_RESPONSE("unknown session");
+    }
+    QMutexLocker locker(&s->lock);
+    if (cmd=="add_node") {
+        if (args.size()!=3) {
+            return ERR_RESPONSE("usage: add_node <session> <x> <y>");
+        }
+        x=args.at(1).toDouble(&okx);
+        y=args.at(2).toDouble(&oky);
+        if (!okx||!oky) {
+            return ERR_RESPONSE("invalid position");
+        }
+        s->analysed=s->generated=false;
+        return OK_RESPONSE(s->graph.add_node(QPointF(x, y)).toByteArray());
+    }
+    if (cmd=="connect") {
+        if (args.size()!=3) {
+            return ERR_RESPONSE("usage: connect <session> <uuid> <uuid>");
+        }
+        id=s->graph.connect(QUuid(args.at(1)), QUuid(args.at(2)));
+        if (id.isNull()) {
+            return ERR_RESPONSE("unknown node");
+        }
+        s->analysed=s->generated=false;
+        return OK_RESPONSE(id.toByteArray());
+    }
+    if (cmd=="disconnect") {
+        if (args.size()!=2) {
+            return ERR_RESPONSE("usage: disconnect <session> <uuid>");
+        }
+        if (!s->graph.disconnect(QUuid(args.at(1)))) {
+            return ERR_RESPONSE("unknown arc");
+        }
+        s->analysed=s->generated=false;
+        return "ok";
+    }
+    if (cmd=="style") {
+        EntrelacStyle style;
+        if (args.size()!=2) {
+            return ERR_RESPONSE("usage: style <session> <name>");
+        }
+        if (!Entrelac::parse_style(args.at(1), &style)) {
+            return ERR_RESPONSE("unknown style");
+        }
+        if (style!=s->style) {
+            s->style=style;
+            s->generated=false;
+        }
+        return "ok";
+    }
+    if (cmd=="generate") {
+        generate(s.data());
+        return OK_RESPONSE(QByteArray::number(s->entrelacs.size()));
+    }
+    if (cmd=="preview") {
+        QRectF viewport;
+        if (args.size()!=6) {
+            return ERR_RESPONSE("usage: preview <session> <path> <x> <y> "
+                                "<w> <h>");
+        }
+        viewport=QRectF(args.at(2).toDouble(&okx), args.at(3).toDouble(&oky),
+                        args.at(4).toDouble(), args.at(5).toDouble());
+        if (!okx||!oky||viewport.isEmpty()) {
+            return ERR_RESPONSE("invalid viewport");
+        }
+        file.setFileName(args.at(1));
+        if (!file.open(QFile::WriteOnly|QFile::Truncate)) {
+            return ERR_RESPONSE("can't open file");
+        }
+        stream.setDevice(&file);
+        /* only trace strands touching the viewport */
+        EntrelacGenerator generator(s->graph, viewport, s->style);
+        EntrelacWriter writer(&stream);
+        Entrelac entrelac((QPointF()));
+        int count=0;
+        while (generator.next(&entrelac)) {
+            writer.consume(entrelac);
+            count++;
+        }
+        if (!writer.flush()) {
+            return ERR_RESPONSE("failed to export entrelacs");
+        }
+        return OK_RESPONSE(QByteArray::number(count));
+    }
+    if (cmd=="export_binary") {
+        if (args.size()!=2) {
+            return ERR_RESPONSE("usage: export_binary <session> <path>");
+        }
+        file.setFileName(args.at(1));
+        if (!file.open(QFile::WriteOnly|QFile::Truncate)) {
+            return ERR_RESPONSE("can't open file");
+        }
+        generate(s.data());
+        EntrelacBinaryWriter writer(&file,
+                                    EntrelacBinaryWriter::bounds(s->entrelacs));
+        foreach (const Entrelac &e, s->entrelacs) {
+            if (!writer.consume(e)) {
+                return ERR_RESPONSE("failed to export entrelacs");
+            }
+        }
+        return OK_RESPONSE(QByteArray::number(s->entrelacs.size()));
+    }
+    if (cmd=="export"||cmd=="export_ribbons"||cmd=="save") {
+        if (cmd=="export_ribbons") {
+            if (args.size()!=3) {
+                return ERR_RESPONSE("usage: export_ribbons <session> <path> "
+                                    "<width>");
+            }
+            x=args.at(2).toDouble(&okx);
+            if (!okx||x<=0) {
+                return ERR_RESPONSE("invalid width");
+            }
+        } else if (args.size()!=2) {
+            return ERR_RESPONSE("usage: "+cmd.toUtf8()+" <session> <path>");
+        }
+        file.setFileName(args.at(1));
+        if (!file.open(QFile::WriteOnly|QFile::Truncate)) {
+            return ERR_RESPONSE("can't open file");
+        }
+        stream.setDevice(&file);
+        if (cmd=="save") {
+            return (s->graph.save(&stream, true)?
+                        QByteArray("ok"): ERR_RESPONSE("failed to save graph"));
+        }
+        generate(s.data());
+        EntrelacWriter writer(&stream);
+        if (cmd=="export_ribbons") {
+            foreach (const Ribbon &r, Ribbon::generate_from(s->entrelacs, x)) {
+                writer.consume(r);
+            }
+        } else {
+            foreach (const Entrelac &e, s->entrelacs) {
+                writer.consume(e);
+            }
+        }
+        if (!writer.flush()) {
+            return ERR_RESPONSE("failed to export entrelacs");
+        }
+        return OK_RESPONSE(QByteArray::number(s->entrelacs.size()));
+    }
+    return ERR_RESPONSE("unknown request");
+}
+
+GenerationSessionPtr GenerationServer::session(const QString &name)
+{
+    QMutexLocker locker(&_sessions_lock);
+    return _sessions.value(name);
+}
+
+void GenerationServer::generate(GenerationSession *session)
+{
+    /* reuse cached results until the graph is edited */
+    if (session->generated) {
+        return;
+    }
+    if (!session->analysed) {
+        session->symmetry=Symmetry::detect(session->graph);
+        session->analysed=true;
+    }
+    session->entrelacs=session->graph.entrelacs(session->symmetry,
+                                                session->style);
+    session->generated=true;
+}
@@ -0,0 +1,92 @@
+#ifndef GENERATIONSERVER_H
+#define GENERATIONSERVER_H
+
+#include <QObject>
+#include <QHash>
+#include <QMutex>
+#include <QThreadPool>
+#include <QSharedPointer>
+#include <QStringList>
+#include "graph.h"
+#include "symmetry.h"
+
+class QLocalServer; /* pre-decl */
+class QLocalSocket; /* pre-decl */
+template<typename T> class QFutureWatcher; /* pre-decl */
+
+/* graph kept in memory with its rotation data and generated entrelacs */
+struct GenerationSession
+{
+    QMutex lock;
+    Graph graph;
+    Symmetry symmetry;
+    bool analysed;
+    EntrelacStyle style;
+    QList<Entrelac> entrelacs;
+    bool generated;
+
+    GenerationSession() :
+        lock(), graph(), symmetry(), analysed(false),
+        style(WEAVE_STYLE), entrelacs(), generated(false)
+    {}
+};
+
+typedef QSharedPointer<GenerationSession> GenerationSessionPtr;
+
+struct GenerationConnection
+{
+    QStringList pending;
+    QFutureWatcher<QByteArray> *watcher;
+};
+
+/*
+ * Local generation daemon. Clients send newline separated requests,
+ * possibly batched, and get one response line per request, in order:
+ *   load <session> <path>              ok <nodes> <arcs>
+ *   unload <session>                   ok
+ *   add_node <session> <x> <y>         ok <node uuid>
+ *   connect <session> <uuid> <uuid>    ok <arc uuid>
+ *   disconnect <session> <uuid>        ok
+ *   style <session> <name>             ok
+ *   generate <session>                 ok <entrelacs>
+ *   export <session> <path>            ok <entrelacs>
+ *   export_ribbons <session> <path> <width>    ok <entrelacs>
+ *   export_binary <session> <path>     ok <entrelacs>
+ *   preview <session> <path> <x> <y> <w> <h>   ok <entrelacs>
+ *   save <session> <path>              ok
+ *   ping                               ok
+ * Style names are weave (default), round_weave, corner_weave, coil,
+ * round_coil and corner_coil. Failures answer "error <reason>".
+ * Batches of different clients run concurrently on a thread pool,
+ * requests on a session are serialized.
+ */
+class GenerationServer : public QObject
+{
+    Q_OBJECT
+private:
+    QLocalServer *_server;
+    QThreadPool _pool;
+    QMutex _sessions_lock;
+    QHash<QString, GenerationSessionPtr> _sessions;
+    QHash<QLocalSocket*, GenerationConnection> _clients;
+public:
+    virtual ~GenerationServer();
+    explicit GenerationServer(QObject *parent = 0);
+
+    bool listen(const QString &name);
+
+private slots:
+    void accept();
+
+private:
+    void read(QLocalSocket *socket);
+    void dispatch(QLocalSocket *socket);
+    void finished(QLocalSocket *socket);
+
+    QByteArray handle_batch(const QStringList &requests);
+    QByteArray handle(const QString &request);
+    GenerationSessionPtr session(const QString &name);
+    void generate(GenerationSession *session);
+};
+
+#endif // GENERATIONSERVER_H
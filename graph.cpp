@@ -1,9 +1,119 @@
 #include "graph.h"
-
+#include "graphbuilder.h"
+#include "blockwriter.h"
+#include "entrelacwriter.h"
+#include "symmetry.h"
+#include "entrelacpolicy.h"
+
+#include <QtConcurrent>
+#include <QThread>
 #include <QtMath>
-#include <QVector2D>
 #include <QTextStream>
-#include <QDebug>
+
+#define SAVE_CHUNK_SIZE 65536
+
+/* indexed by EntrelacStyle */
+static const char *const STYLE_NAMES[]={
+    "weave", "round_weave", "corner_weave",
+    "coil", "round_coil", "corner_coil"
+};
+
+struct SaveChunk
+{
+    int begin;
+    int end;
+    QByteArray data;
+};
+
+static void write_node(BlockWriter *writer, uint id, const Node *n)
+{
+    /* n<id>=[<x>;<y>] */
+    writer->append('n');
+    writer->append_uint(id);
+    writer->append("=[");
+    writer->append_real(n->position().x());
+    writer->append(';');
+    writer->append_real(n->position().y());
+    writer->append("]\n");
+}
+
+static void write_arc(BlockWriter *writer, const QHash<const Node*, uint> &ids,
+                      const Arc *a)
+{
+    /* n<src> -> n<dst> */
+    writer->append('n');
+    writer->append_uint(ids.value(a->const_src()));
+    writer->append(" -> n");
+    writer->append_uint(ids.value(a->const_dst()));
+    writer->append('\n');
+}
+
+template<typename Formatter>
+static void save_parallel(BlockWriter *writer, int count, Formatter format)
+{
+    QVector<SaveChunk> chunks;
+    int wave=QThread::idealThreadCount()*2;
+    /* format chunks concurrently, a wave at a time to bound memory */
+    for (int begin=0; begin<count; begin+=wave*SAVE_CHUNK_SIZE) {
+        chunks.clear();
+        for (int i=begin; i<count&&i<begin+wave*SAVE_CHUNK_SIZE;
+             i+=SAVE_CHUNK_SIZE) {
+            chunks.append(SaveChunk{i, qMin(i+SAVE_CHUNK_SIZE, count),
+                                    QByteArray()});
+        }
+        QtConcurrent::blockingMap(chunks, [&](SaveChunk &chunk) {
+            BlockWriter w;
+            for (int i=chunk.begin; i<chunk.end; ++i) {
+                format(&w, i);
+            }
+            chunk.data=w.data();
+        });
+        /* write in order */
+        foreach (const SaveChunk &chunk, chunks) {
+            writer->append(chunk.data);
+        }
+    }
+}
+
+/* generation with the tracer of a style, see run_with_style */
+struct ListGenerationJob
+{
+    const Graph *graph;
+    const Symmetry *symmetry;   /* null for plain generation */
+    QList<Entrelac> entrelacs;
+
+    template<class Tracer>
+    void run()
+    {
+        entrelacs=(symmetry==nullptr?
+                       Tracer::generate_from(*graph):
+                       Tracer::generate_from(*graph, *symmetry));
+    }
+};
+
+struct SinkGenerationJob
+{
+    const Graph *graph;
+    EntrelacSink *sink;
+    bool ok;
+
+    template<class Tracer>
+    void run()
+    {
+        PendingPassageTable pending;
+        PendingTableAccounting table(&pending);
+        Entrelac entrelac((QPointF()));
+        PendingTableAccounting::fill(*graph, &pending);
+        /* hand over each entrelac as soon as it is closed */
+        ok=true;
+        while (Tracer::next(&table, &entrelac)) {
+            if (!sink->consume(entrelac)) {
+                ok=false;
+                return;
+            }
+        }
+    }
+};
 
 Graph::~Graph()
 {
@@ -33,44 +143,57 @@ void Graph::clear()
 
 bool Graph::parse(QTextStream *input)
 {
-    bool ret;
     QString line;
-    uint id, id_src, id_dst;
-    qreal x, y;
-    QStringList data;
-    QHash<uint, QUuid> ids;
+    GraphRecord record;
+    GraphBuilder builder;
     /* clear current data */
     clear();
     /* parse input stream */
     while ((*input).readLineInto(&line)) {
-        line=line.trimmed();
-        if (!line.startsWith('#')) {
-            if (line.contains('=')) {
-                /* process node decl */
-                line.remove(0,1);
-                data=line.split('=');
-                if (data.size()!=2) { goto abrt; }
-                id=data.first().toUInt(&ret);
-                if (!ret) { goto abrt; }
-                data=data.last().split(';');
-                if (data.size()!=2) { ret=false; goto abrt; }
-                x=data.first().right(data.first().length()-1).toDouble(&ret);
-                if (!ret) { goto abrt; }
-                y=data.last().left(data.last().length()-1).toDouble(&ret);
-                if (!ret) { goto abrt; }
-                ids.insert(id, add_node(QPointF(x, y)));
-            } else {
-                /* process arc decl*/
-                data=line.split("->");
-                if (data.size()!=2) { ret=false; goto abrt; }
-                line=data.first().trimmed();
-                id_src=line.right(line.length()-1).toUInt(&ret);
-                if (!ret) { goto abrt; }
-                line=data.last().trimmed();
-                id_dst=line.right(line.length()-1).toUInt(&ret);
-                if (!ret) { goto abrt; }
-                connect(ids.value(id_src), ids.value(id_dst));
-            }
+        if (!parse_line(line, &record)) {
+            return false;
+        }
+        builder.apply(record);
+    }
+    /* build graph at once */
+    return builder.build(this);
+}
+
+bool Graph::parse_line(const QString &input_line, GraphRecord *record)
+{
+    bool ret;
+    QString line;
+    QStringList data;
+    qreal x, y;
+    record->type=COMMENT_RECORD;
+    line=input_line.trimmed();
+    if (!line.startsWith('#')) {
+        if (line.contains('=')) {
+            /* process node decl */
+            line.remove(0,1);
+            data=line.split('=');
+            if (data.size()!=2) { ret=false; goto abrt; }
+            record->id=data.first().toUInt(&ret);
+            if (!ret) { goto abrt; }
+            data=data.last().split(';');
+            if (data.size()!=2) { ret=false; goto abrt; }
+            x=data.first().right(data.first().length()-1).toDouble(&ret);
+            if (!ret) { goto abrt; }
+            y=data.last().left(data.last().length()-1).toDouble(&ret);
+            if (!ret) { goto abrt; }
+            record->type=NODE_RECORD;
+            record->pos=QPointF(x, y);
+        } else {
+            /* process arc decl*/
+            data=line.split("->");
+            if (data.size()!=2) { ret=false; goto abrt; }
+            line=data.first().trimmed();
+            record->id=line.right(line.length()-1).toUInt(&ret);
+            if (!ret) { goto abrt; }
+            line=data.last().trimmed();
+            record->dst_id=line.right(line.length()-1).toUInt(&ret);
+            if (!ret) { goto abrt; }
+            record->type=ARC_RECORD;
         }
     }
     /* success */
@@ -79,28 +202,48 @@ abrt:
     return ret;
 }
 
-bool Graph::save(QTextStream *output)
+bool Graph::save(QTextStream *output, bool parallel)
 {
-    uint ctr=0;
-    QHash<QUuid, uint> ids;
-    NodeHash::const_iterator it;
-    (*output) << "# ---------- nodes ----------" << endl;
-    for (it=_nodes.begin(); it!=_nodes.end(); ++it) {
-        ids.insert(it.key(), ctr);
-        (*output) << QString("n%0=[%1;%2]").arg(ctr)
-                                        .arg(it.value()->position().x())
-                                        .arg(it.value()->position().y())
-               << endl;
-        ctr++;
+    QVector<const Node*> nodes;
+    QVector<const Arc*> arcs;
+    QHash<const Node*, uint> ids;
+    NodeHash::const_iterator nit;
+    ArcHash::const_iterator ait;
+    BlockWriter writer(output);
+    /* index nodes by pointer, no QUuid hashing needed afterwards */
+    nodes.reserve(_nodes.size());
+    ids.reserve(_nodes.size());
+    for (nit=_nodes.constBegin(); nit!=_nodes.constEnd(); ++nit) {
+        ids.insert(nit.value(), nodes.size());
+        nodes.append(nit.value());
     }
-    (*output) << "# ---------- arcs ----------" << endl;
-    foreach (Arc *a, _arcs.values()) {
-        (*output) << QString("n%0 -> n%1")
-                     .arg(ids.value(a->const_src()->id()))
-                     .arg(ids.value(a->const_dst()->id()))
-                  << endl;
+    arcs.reserve(_arcs.size());
+    for (ait=_arcs.constBegin(); ait!=_arcs.constEnd(); ++ait) {
+        arcs.append(ait.value());
+    }
+    /* write nodes */
+    writer.append("# ---------- nodes ----------\n");
+    if (parallel) {
+        save_parallel(&writer, nodes.size(), [&](BlockWriter *w, int i) {
+            write_node(w, i, nodes.at(i));
+        });
+    } else {
+        for (int i=0; i<nodes.size(); ++i) {
+            write_node(&writer, i, nodes.at(i));
+        }
+    }
+    /* write arcs */
+    writer.append("# ---------- arcs ----------\n");
+    if (parallel) {
+        save_parallel(&writer, arcs.size(), [&](BlockWriter *w, int i) {
+            write_arc(w, ids, arcs.at(i));
+        });
+    } else {
+        for (int i=0; i<arcs.size(); ++i) {
+            write_arc(&writer, ids, arcs.at(i));
+        }
     }
-    return true;
+    return writer.flush();
 }
 
 QUuid Graph::add_node(const QPointF &pos)
@@ -264,9 +407,15 @@ QList<const Arc *> Graph::arcs() const
     return as;
 }
 
-QList<Entrelac> Graph::entrelacs() const
+QList<Entrelac> Graph::entrelacs(EntrelacStyle style) const
 {
-    return Entrelac::generate_from(*this);
+    return Entrelac::generate_from(*this, style);
+}
+
+QList<Entrelac> Graph::entrelacs(const Symmetry &symmetry,
+                                 EntrelacStyle style) const
+{
+    return Entrelac::generate_from(*this, symmetry, style);
 }
 
 qreal Graph::distance(const QPointF &src, const QPointF &dst)
@@ -286,238 +435,43 @@ Entrelac::Entrelac(const QPointF &start) :
 
 }
 
-QList<Entrelac> Entrelac::generate_from(const Graph &graph)
+QList<Entrelac> Entrelac::generate_from(const Graph &graph,
+                                        EntrelacStyle style)
 {
-    QList<Entrelac> entrelacs;
-    PendingConnectionTable pending_table;
-    /* initialize pending table */
-    foreach (const Arc *a, graph.arcs()) {
-        pending_table.insert(a, 4);
-    }
-    /* generate entrelacs */
-    while (!pending_table.empty()) {
-        entrelacs.append(generate_from(&pending_table));
-    }
-    return entrelacs;
-}
-
-#define DEBUG_POS(pos) "(" << pos.x() << "," << pos.y() << ")"
-#define DEBUG_ARC(arc, name)                                                   \
-    qDebug() << "D > > " << name << " arc is " << arc->id() << "("             \
-             << DEBUG_POS(arc->const_src()->position())  << "->"               \
-             << DEBUG_POS(arc->const_dst()->position()) << ")" << endl;
-
-Entrelac Entrelac::generate_from(PendingConnectionTable *pending_table)
-{
-    qDebug() << "D > starting new entrelacs" << endl;
-    const Arc *start_arc, *end_arc;
-    const Node *start_node, *end_node;
-    QPointF start_curve, end_curve;
-    RotationDirection dir;
-    qreal min_ang;
-    PendingConnectionTable::iterator it;
-    /* select first arc in pending table */
-    start_arc=pending_table->begin().key();
-    /* select vector direction depending on pending connection count */
-    start_node=start_arc->const_src();
-    end_node=start_arc->const_dst();
-    if (pending_table->begin().value()==4) {
-        dir=COUNTERCLOCKWISE_DIRECTION;
-    } else {
-        dir=CLOCKWISE_DIRECTION;
-    }
-    /* compute global start position */
-    Entrelac entrelac(midpoint(start_node->position(), end_node->position()));
-    qDebug() << "D > > entrelacs starts at " << DEBUG_POS(entrelac.start())
-             << endl;
-    /* loop while entrelac is not closed */
-    while (!pending_table->empty()&&
-           (start_curve==entrelac.start()||end_curve!=entrelac.start())) {
-        /* find next arc */
-        end_arc=next_arc(end_node, start_arc, dir, &min_ang);
-        DEBUG_ARC(start_arc, "start_arc")
-        DEBUG_ARC(end_arc, "end_arc")
-        /* compute cubic curve point for start arc */
-        start_curve=midpoint(start_node->position(), end_node->position());
-        /* update start and end node for end arc and next iteration */
-        start_node=end_node;
-        end_node=(start_node==end_arc->const_src()?
-                      end_arc->const_dst(): end_arc->const_src());
-        /* compute cubic curve point for end arc */
-        end_curve=midpoint(start_node->position(), end_node->position());
-        /* add cubic curve to entrelacs */
-        qDebug() << "D > > curve starts at " << DEBUG_POS(start_curve)
-                 << "and ends at " << DEBUG_POS(end_curve) << endl;
-        entrelac.add_subcurve(generate_curve(start_curve, end_curve,
-                                             start_node->position(), dir, min_ang));
-        /* update pending table */
-        it=pending_table->find(start_arc);
-        it.value()-=1;
-        if (it.value()==0) {
-            pending_table->erase(it);
-        }
-        it=pending_table->find(end_arc);
-        it.value()-=1;
-        if (it.value()==0) {
-            pending_table->erase(it);
-        }
-        /* change arc */
-        start_arc=end_arc;
-        /* change direction */
-        dir=(dir==CLOCKWISE_DIRECTION?
-                 COUNTERCLOCKWISE_DIRECTION: CLOCKWISE_DIRECTION);
-    }
-    qDebug() << "D > ending current entrelac" << endl;
-    return entrelac;
-}
-
-const Arc *Entrelac::next_arc(const Node *n, const Arc *a_ref,
-                              RotationDirection dir, qreal *min_ang)
-{
-    const Arc *min_a;
-    qreal ang, ang_ref, max_ang;
-    bool augmented=false;
-    (*min_ang)=2*M_PI;
-    max_ang=0;
-    if (n->arcs().size()>1) {
-        /* compute angle between x axis and ref. vector */
-        ang_ref=angle(n, a_ref);
-        /* find closest vector (angular distance) */
-        foreach (const Arc* a, n->arcs()) {
-            if (a!=a_ref) {
-                ang=angle(n, a);
-                if (ang<ang_ref) {
-                    ang+=2*M_PI;
-                    augmented=true;
-                }
-                ang=ang-ang_ref;
-                if (dir==COUNTERCLOCKWISE_DIRECTION&&ang<(*min_ang)) {
-                    min_a=a;
-                    if (augmented) {
-                        ang=qAbs(ang-2*M_PI);
-                    }
-                    (*min_ang)=ang;
-                } else if (dir==CLOCKWISE_DIRECTION&&ang>max_ang) {
-                    min_a=a;
-                    max_ang=ang;
-                    (*min_ang)=ang;
-                    if (augmented) {
-                        (*min_ang)=ang_ref-((*min_ang)+ang_ref-2*M_PI);
-                    } else {
-                        (*min_ang)=2*M_PI-(*min_ang);
-                    }
-                }
-            }
-        }
-    } else {
-        min_a=n->arcs().first();
-    }
-    return min_a;
+    ListGenerationJob job={&graph, nullptr, QList<Entrelac>()};
+    run_with_style(style, &job);
+    return job.entrelacs;
 }
 
-qreal Entrelac::angle(const Node *n, const Arc *a, qreal ref_angle)
+bool Entrelac::generate_from(const Graph &graph, EntrelacSink *sink,
+                             EntrelacStyle style)
 {
-    qreal ang, dx, dy, ref_cos, ref_sin;
-    /* compute vector */
-    if (a->const_src()==n) {
-        dx=a->const_dst()->position().x()-n->position().x();
-        dy=a->const_dst()->position().y()-n->position().y();
-    } else {
-        dx=a->const_src()->position().x()-n->position().x();
-        dy=a->const_src()->position().y()-n->position().y();
-    }
-    /* apply rotation if necessary */
-    if (ref_angle > 0.0) {
-        ref_cos=qCos(ref_angle);
-        ref_sin=qSin(ref_angle);
-        dx=dx*ref_cos-dy*ref_sin;
-        dy=dx*ref_sin+dy*ref_cos;
-    }
-    /* return angle */
-    ang=qAtan2(dy,dx);
-    if (ang<0) {
-        ang=(2*M_PI)+ang;
-    }
-    return ang;
+    SinkGenerationJob job={&graph, sink, false};
+    run_with_style(style, &job);
+    return job.ok;
 }
 
-QPointF Entrelac::midpoint(const QPointF &src, const QPointF &dst)
+QList<Entrelac> Entrelac::generate_from(const Graph &graph,
+                                        const Symmetry &symmetry,
+                                        EntrelacStyle style)
 {
-    return QPointF((dst.x()+src.x())/2, (dst.y()+src.y())/2);
+    ListGenerationJob job={&graph, &symmetry, QList<Entrelac>()};
+    run_with_style(style, &job);
+    return job.entrelacs;
 }
 
-CubicCurve Entrelac::generate_curve(const QPointF &start_curve,
-                                    const QPointF &end_curve,
-                                    const QPointF &center,
-                                    RotationDirection dir,
-                                    qreal ang)
-{
-    QPointF scp, dcp;
-    QVector2D dirv, pdirv, fdirv, sdirv;
-    qreal rcos, rsin, len, scale;
-    rcos=0;
-    rsin=1;
-    /*
-    if (dir==CLOCKWISE_DIRECTION) {
-        rsin=-rsin;
-    }
-    */
-    scale=adaptive_scale(ang);
-    /* compute control points coordinates  */
-    /* compute scp */
-    dirv.setX(start_curve.x()-center.x());
-    dirv.setY(start_curve.y()-center.y());
-    pdirv.setX(dirv.x()*rcos+dirv.y()*rsin);
-    pdirv.setY(dirv.y()*rcos-dirv.x()*rsin);
-    pdirv.normalize();
-    pdirv*=dirv.length();
-    fdirv.setX(start_curve.x()-center.x()+pdirv.x());
-    fdirv.setY(start_curve.y()-center.y()+pdirv.y());
-    len=fdirv.length()/2;
-    fdirv.normalize();
-    fdirv*=len;
-    scp.setX(center.x()+fdirv.x());
-    scp.setY(center.y()+fdirv.y());
-    sdirv.setX(scp.x()-start_curve.x());
-    sdirv.setY(scp.y()-start_curve.y());
-    scp.setX(start_curve.x()+scale*sdirv.x());
-    scp.setY(start_curve.y()+scale*sdirv.y());
-    /* compute dcp */
-    dirv.setX(center.x()-end_curve.x());
-    dirv.setY(center.y()-end_curve.y());
-    pdirv.setX(dirv.x()*rcos+dirv.y()*rsin);
-    pdirv.setY(dirv.y()*rcos-dirv.x()*rsin);
-    pdirv.normalize();
-    pdirv*=dirv.length();
-    fdirv.setX(end_curve.x()-center.x()+pdirv.x());
-    fdirv.setY(end_curve.y()-center.y()+pdirv.y());
-    len=fdirv.length()/2;
-    fdirv.normalize();
-    fdirv*=len;
-    dcp.setX(center.x()+fdirv.x());
-    dcp.setY(center.y()+fdirv.y());
-    sdirv.setX(dcp.x()-end_curve.x());
-    sdirv.setY(dcp.y()-end_curve.y());
-    dcp.setX(end_curve.x()+scale*sdirv.x());
-    dcp.setY(end_curve.y()+scale*sdirv.y());
-    qDebug() << "D > > > generating curve with scp " << DEBUG_POS(scp)
-             << " dcp " << DEBUG_POS(dcp) << endl;
-    /* return cubic curve */
-    return CubicCurve(scp, dcp, end_curve);
-}
-
-qreal Entrelac::adaptive_scale(qreal ang)
-{
-    qreal coeff=1;
-    if (ang <= M_PI) {
-        coeff=normalize(ang, 0, M_PI, 0, 1); // normalization [0,PI]->[0,1]
-    } else {
-        coeff*=normalize(ang, M_PI, 2*M_PI, 1, 3); //normalization [PI,2*PI]->[0,1]
+bool Entrelac::parse_style(const QString &name, EntrelacStyle *style)
+{
+    for (int i=0; i<int(sizeof(STYLE_NAMES)/sizeof(*STYLE_NAMES)); ++i) {
+        if (name==QLatin1String(STYLE_NAMES[i])) {
+            (*style)=EntrelacStyle(i);
+            return true;
+        }
     }
-    return coeff;
+    return false;
 }
 
-qreal Entrelac::normalize(qreal x, qreal min_x, qreal max_x, qreal to_min_x, qreal to_max_x)
+QPointF Entrelac::midpoint(const QPointF &src, const QPointF &dst)
 {
-    return to_min_x + ((x-min_x) * (to_max_x-to_min_x)) / (max_x-min_x);
+    return QPointF((dst.x()+src.x())/2, (dst.y()+src.y())/2);
 }
@@ -5,15 +5,18 @@
 #include <QHash>
 #include <QPointF>
 #include <QList>
+#include <QVector>
+#include "coords.h"
 
 class QTextStream;
 class Arc; /* pre-decl */
 
 class Node
 {
+    friend class GraphBuilder;
 private:
     QUuid _id;
-    QPointF _pos;
+    StoredPoint _pos;
     QList<const Arc*> _arcs;
 public:
     virtual ~Node() {}
@@ -21,6 +24,9 @@ public:
         _id(QUuid::createUuid()),
         _pos(pos), _arcs()
     {}
+    Node(const QUuid &id, const QPointF &pos) :
+        _id(id), _pos(pos), _arcs()
+    {}
     inline QUuid id() const
     { return _id; }
     inline QPointF position() const
@@ -53,6 +59,9 @@ public:
         _id(QUuid::createUuid()),
         _src(src), _dst(dst)
     {}
+    Arc(const QUuid &id, Node *src, Node *dst) :
+        _id(id), _src(src), _dst(dst)
+    {}
     inline QUuid id() const
     { return _id; }
     inline Node *src()
@@ -71,10 +80,13 @@ typedef QHash<QUuid, Arc*> ArcHash;
 class CubicCurve
 {
 private:
-    QPointF _src_ctl_pt;
-    QPointF _dst_ctl_pt;
-    QPointF _dst_pt;
+    StoredPoint _src_ctl_pt;
+    StoredPoint _dst_ctl_pt;
+    StoredPoint _dst_pt;
 public:
+    CubicCurve() :
+        _src_ctl_pt(), _dst_ctl_pt(), _dst_pt()
+    {}
     CubicCurve(const QPointF &scp, const QPointF &dcp, const QPointF &dp) :
         _src_ctl_pt(scp), _dst_ctl_pt(dcp), _dst_pt(dp)
     {}
@@ -86,21 +98,36 @@ public:
     { return _dst_pt; }
 };
 
-typedef QList<CubicCurve> CubicCurveList;
+/* stored inline, QList would allocate every curve on its own */
+Q_DECLARE_TYPEINFO(CubicCurve, Q_MOVABLE_TYPE);
+typedef QVector<CubicCurve> CubicCurveList;
 
 class Graph; /* pre-decl */
+class EntrelacSink; /* pre-decl */
+class Symmetry; /* pre-decl */
 
 enum RotationDirection {
     CLOCKWISE_DIRECTION,
     COUNTERCLOCKWISE_DIRECTION
 };
 
-typedef QHash<const Arc*, ushort> PendingConnectionTable;
+/* strand shapes, see entrelacpolicy.h */
+enum EntrelacStyle {
+    WEAVE_STYLE,            /* alternating, adaptive bezier curves */
+    ROUND_WEAVE_STYLE,      /* alternating, circular arcs */
+    CORNER_WEAVE_STYLE,     /* alternating, straight corners */
+    COIL_STYLE,             /* constant direction, adaptive bezier curves */
+    ROUND_COIL_STYLE,       /* constant direction, circular arcs */
+    CORNER_COIL_STYLE       /* constant direction, straight corners */
+};
+
+/* free strand passages of each arc, see entrelacpolicy.h */
+typedef QHash<const Arc*, ushort> PendingPassageTable;
 
 class Entrelac
 {
 private:
-    QPointF _start;
+    StoredPoint _start;
     CubicCurveList _subcurves;
 public:
     virtual ~Entrelac();
@@ -113,25 +140,36 @@ public:
     inline void add_subcurve(const CubicCurve &curve)
     { _subcurves.append(curve); }
 
-    static QList<Entrelac> generate_from(const Graph &graph);
+    static QList<Entrelac> generate_from(const Graph &graph,
+                                         EntrelacStyle style=WEAVE_STYLE);
+    static bool generate_from(const Graph &graph, EntrelacSink *sink,
+                              EntrelacStyle style=WEAVE_STYLE);
+    static QList<Entrelac> generate_from(const Graph &graph,
+                                         const Symmetry &symmetry,
+                                         EntrelacStyle style=WEAVE_STYLE);
 
-private:
-    static Entrelac generate_from(PendingConnectionTable *pending_table);
-    static const Arc *next_arc(const Node *n, const Arc *a_ref,
-                               RotationDirection dir, qreal *min_ang);
-    static qreal angle(const Node *n, const Arc *a, qreal ref_angle=0.0);
+    static bool parse_style(const QString &name, EntrelacStyle *style);
     static QPointF midpoint(const QPointF &src, const QPointF &dst);
-    static CubicCurve generate_curve(const QPointF &start_curve,
-                                     const QPointF &end_curve,
-                                     const QPointF &center,
-                                     RotationDirection dir, qreal ang);
-    static qreal adaptive_scale(qreal ang);
-    static qreal normalize(qreal x, qreal min_x, qreal max_x,
-                           qreal to_min_x, qreal to_max_x);
+};
+
+enum GraphRecordType {
+    COMMENT_RECORD,
+    NODE_RECORD,
+    ARC_RECORD
+};
+
+struct GraphRecord
+{
+    GraphRecordType type;
+    uint id;        /* node id or arc source id */
+    uint dst_id;    /* arc destination id */
+    QPointF pos;    /* node position */
 };
 
 class Graph
 {
+    friend class GraphBuilder;
+    friend class EntrelacGenerator;
 private:
     NodeHash _nodes;
     ArcHash _arcs;
@@ -142,7 +180,8 @@ public:
     void clear();
 
     bool parse(QTextStream *input);
-    bool save(QTextStream *output);
+    static bool parse_line(const QString &input_line, GraphRecord *record);
+    bool save(QTextStream *output, bool parallel=false);
 
     QUuid add_node(const QPointF &pos);
     bool remove_node(const QPointF &pos);
@@ -161,7 +200,9 @@ public:
     const Arc *arc(const QUuid &aid) const;
     QList<const Arc*> arcs() const;
 
-    QList<Entrelac> entrelacs() const;
+    QList<Entrelac> entrelacs(EntrelacStyle style=WEAVE_STYLE) const;
+    QList<Entrelac> entrelacs(const Symmetry &symmetry,
+                              EntrelacStyle style=WEAVE_STYLE) const;
 
 private:
     qreal distance(const QPointF &src, const QPointF &dst);
@@ -0,0 +1,145 @@
+#include "graphbuilder.h"
+
+#define NODE_ID_KIND 0
+#define ARC_ID_KIND 1
+
+GraphBuilder::~GraphBuilder()
+{
+
+}
+
+GraphBuilder::GraphBuilder() :
+    _positions(),
+    _pairs(),
+    _record_ids(),
+    _base_id()
+{
+
+}
+
+void GraphBuilder::reserve(int node_count, int arc_count)
+{
+    _positions.reserve(node_count);
+    _pairs.reserve(2*arc_count);
+}
+
+void GraphBuilder::clear()
+{
+    _positions.clear();
+    _pairs.clear();
+    _record_ids.clear();
+}
+
+uint GraphBuilder::add_node(const QPointF &pos)
+{
+    _positions.append(pos);
+    return _positions.size()-1;
+}
+
+uint GraphBuilder::add_nodes(const QVector<QPointF> &positions)
+{
+    uint first=_positions.size();
+    _positions+=positions;
+    return first;
+}
+
+void GraphBuilder::connect(uint src, uint dst)
+{
+    _pairs.append(src);
+    _pairs.append(dst);
+}
+
+void GraphBuilder::connect(const QVector<uint> &pairs)
+{
+    _pairs+=pairs;
+    if (pairs.size()%2!=0) {
+        /* drop dangling index */
+        _pairs.removeLast();
+    }
+}
+
+void GraphBuilder::apply(const GraphRecord &record)
+{
+    QHash<uint, uint>::const_iterator sit, dit;
+    switch (record.type) {
+    case NODE_RECORD:
+        _record_ids.insert(record.id, add_node(record.pos));
+        break;
+    case ARC_RECORD:
+        sit=_record_ids.constFind(record.id);
+        dit=_record_ids.constFind(record.dst_id);
+        if (sit!=_record_ids.constEnd()&&dit!=_record_ids.constEnd()) {
+            connect(sit.value(), dit.value());
+        }
+        break;
+    case COMMENT_RECORD:
+        break;
+    }
+}
+
+bool GraphBuilder::build(Graph *graph)
+{
+    QVector<Node*> nodes;
+    QVector<int> degrees;
+    Node *src, *dst;
+    Arc *arc;
+    uint n=_positions.size();
+    int i;
+    /* validate indices before allocating anything */
+    for (i=0; i<_pairs.size(); ++i) {
+        if (_pairs.at(i)>=n) {
+            return false;
+        }
+    }
+    _base_id=QUuid::createUuid();
+    /* create nodes */
+    nodes.reserve(n);
+    graph->_nodes.reserve(graph->_nodes.size()+n);
+    for (i=0; i<int(n); ++i) {
+        nodes.append(new Node(node_id(i), _positions.at(i)));
+        graph->_nodes.insert(nodes.last()->id(), nodes.last());
+    }
+    /* count degrees then size adjacency lists once */
+    degrees.fill(0, n);
+    for (i=0; i<_pairs.size(); i+=2) {
+        degrees[_pairs.at(i)]++;
+        if (_pairs.at(i+1)!=_pairs.at(i)) {
+            degrees[_pairs.at(i+1)]++;
+        }
+    }
+    for (i=0; i<int(n); ++i) {
+        nodes.at(i)->_arcs.reserve(degrees.at(i));
+    }
+    /* create arcs and fill adjacency lists */
+    graph->_arcs.reserve(graph->_arcs.size()+arc_count());
+    for (i=0; i<_pairs.size(); i+=2) {
+        src=nodes.at(_pairs.at(i));
+        dst=nodes.at(_pairs.at(i+1));
+        arc=new Arc(arc_id(i/2), src, dst);
+        src->_arcs.append(arc);
+        if (dst!=src) {
+            dst->_arcs.append(arc);
+        }
+        graph->_arcs.insert(arc->id(), arc);
+    }
+    return true;
+}
+
+QUuid GraphBuilder::node_id(uint index) const
+{
+    return derive_id(index, NODE_ID_KIND);
+}
+
+QUuid GraphBuilder::arc_id(uint index) const
+{
+    return derive_id(index, ARC_ID_KIND);
+}
+
+QUuid GraphBuilder::derive_id(uint index, ushort kind) const
+{
+    /* keep random bits of the base id, index and kind make it unique */
+    QUuid id=_base_id;
+    id.data1+=index;
+    id.data2^=kind;
+    return id;
+}
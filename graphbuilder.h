@@ -0,0 +1,51 @@
+#ifndef GRAPHBUILDER_H
+#define GRAPHBUILDER_H
+
+#include <QVector>
+#include <QHash>
+#include <QPointF>
+#include <QUuid>
+#include "graph.h"
+
+/*
+ * Bulk graph construction. Nodes are referenced by index, arcs are
+ * index pairs, nothing is allocated until build() which creates all
+ * nodes and arcs at once, derives ids from a single random uuid and
+ * fills adjacency lists in one counting pass (no per-arc lookups).
+ */
+class GraphBuilder
+{
+private:
+    QVector<QPointF> _positions;
+    QVector<uint> _pairs;
+    QHash<uint, uint> _record_ids;
+    QUuid _base_id;
+public:
+    virtual ~GraphBuilder();
+    GraphBuilder();
+
+    void reserve(int node_count, int arc_count);
+    void clear();
+
+    inline int node_count() const
+    { return _positions.size(); }
+    inline int arc_count() const
+    { return _pairs.size()/2; }
+
+    uint add_node(const QPointF &pos);
+    uint add_nodes(const QVector<QPointF> &positions);
+    void connect(uint src, uint dst);
+    void connect(const QVector<uint> &pairs);
+
+    void apply(const GraphRecord &record);
+
+    bool build(Graph *graph);
+
+    QUuid node_id(uint index) const;
+    QUuid arc_id(uint index) const;
+
+private:
+    QUuid derive_id(uint index, ushort kind) const;
+};
+
+#endif // GRAPHBUILDER_H
@@ -9,13 +9,52 @@
 
 #define NODE_WIDTH 10
 
+/* fixed stacking of layers, whatever the order items are created in */
+#define NODE_Z_VALUE 0.
+#define ARC_Z_VALUE 1.
+#define RIBBON_Z_VALUE 2.
+#define STRAND_Z_VALUE 3.
+
+static QRectF node_rect(const Node *n)
+{
+    return QRectF(n->position().x()-(NODE_WIDTH/2),
+                  n->position().y()-(NODE_WIDTH/2),
+                  NODE_WIDTH, NODE_WIDTH);
+}
+
+static quint64 arc_hash(const Arc *a)
+{
+    /* both orientations draw the same line */
+    return hash_mix(point_hash(a->const_src()->position())+
+                    point_hash(a->const_dst()->position()));
+}
+
+static QLineF arc_line(const Arc *a)
+{
+    return QLineF(a->const_src()->position(), a->const_dst()->position());
+}
+
+static QPainterPath polyline_path(const QPolygonF &polyline)
+{
+    QPainterPath path;
+    path.addPolygon(polyline);
+    return path;
+}
+
 GraphDrawer::~GraphDrawer()
 {
 
 }
 
 GraphDrawer::GraphDrawer(QGraphicsScene *scene) :
-    _scene(scene)
+    _scene(scene),
+    _node_items(),
+    _arc_items(),
+    _strand_items(),
+    _ribbon_items(),
+    _flattening(),
+    _strand_paths(),
+    _scale(1.)
 {
 
 }
@@ -23,44 +62,138 @@ GraphDrawer::GraphDrawer(QGraphicsScene *scene) :
 void GraphDrawer::clear()
 {
     _scene->clear();
+    _node_items.clear();
+    _arc_items.clear();
+    _strand_items.clear();
+    _ribbon_items.clear();
+    _flattening.clear();
+    _strand_paths.clear();
 }
 
 void GraphDrawer::draw(const Graph &graph)
 {
     QGraphicsEllipseItem *eitm;
     QGraphicsLineItem *litm;
-    /* draw nodes */
+    NodeItemHash stale_nodes=_node_items;
+    ArcItemHash stale_arcs=_arc_items;
+    NodeItemHash::iterator nit;
+    ArcItemHash::iterator ait;
+    quint64 key;
+    /* draw nodes, a moved node is a removed node plus an added one */
     foreach (const Node *n, graph.nodes()) {
-        eitm=new QGraphicsEllipseItem(n->position().x()-(NODE_WIDTH/2),
-                                      n->position().y()-(NODE_WIDTH/2),
-                                      NODE_WIDTH, NODE_WIDTH);
+        key=point_hash(n->position());
+        if ((nit=stale_nodes.find(key))!=stale_nodes.end()) {
+            stale_nodes.erase(nit);
+            continue;
+        }
+        eitm=new QGraphicsEllipseItem(node_rect(n));
         eitm->setPen(QPen(QBrush(Qt::black), 1.));
         eitm->setBrush(QBrush(Qt::black));
+        eitm->setZValue(NODE_Z_VALUE);
         _scene->addItem(eitm);
+        _node_items.insert(key, eitm);
     }
     /* draw arcs */
     foreach (const Arc *a, graph.arcs()) {
-        litm=new QGraphicsLineItem(a->const_src()->position().x(),
-                                   a->const_src()->position().y(),
-                                   a->const_dst()->position().x(),
-                                   a->const_dst()->position().y());
+        key=arc_hash(a);
+        if ((ait=stale_arcs.find(key))!=stale_arcs.end()) {
+            stale_arcs.erase(ait);
+            continue;
+        }
+        litm=new QGraphicsLineItem(arc_line(a));
         litm->setPen(QPen(QBrush(Qt::black), 1.));
+        litm->setZValue(ARC_Z_VALUE);
         _scene->addItem(litm);
+        _arc_items.insert(key, litm);
     }
+    /* remove deleted nodes and arcs */
+    remove(&_node_items, stale_nodes);
+    remove(&_arc_items, stale_arcs);
 }
 
 void GraphDrawer::draw(const QList<Entrelac> &entrelacs)
 {
-    QPainterPath path;
     QGraphicsPathItem *pitm;
-    foreach (const Entrelac e, entrelacs) {
-        path=QPainterPath(e.start());
-        foreach (const CubicCurve cc, e.subcurves()) {
-            path.cubicTo(cc.src_ctl_pt(), cc.dst_ctl_pt(), cc.dst_pt());
+    PathItemHash stale=_strand_items;
+    PathItemHash::iterator it;
+    quint64 key;
+    QList<QPolygonF> polylines;
+    /* only strands the cache has not seen yet get flattened */
+    _flattening.set_entrelacs(entrelacs);
+    polylines=_flattening.polylines(_scale);
+    /* items follow strand indices of the cache, for strand_at */
+    _strand_paths.clear();
+    _strand_paths.reserve(entrelacs.size());
+    for (int i=0; i<entrelacs.size(); ++i) {
+        key=FlatteningCache::signature(entrelacs.at(i));
+        if ((it=stale.find(key))!=stale.end()) {
+            /* strand already drawn at this scale */
+            _strand_paths.append(it.value());
+            stale.erase(it);
+            continue;
         }
-        pitm=new QGraphicsPathItem(path);
+        pitm=new QGraphicsPathItem(polyline_path(polylines.at(i)));
         pitm->setPen(QPen(QBrush(Qt::red), 1.));
         pitm->setBrush(QBrush(Qt::transparent));
+        pitm->setZValue(STRAND_Z_VALUE);
+        _scene->addItem(pitm);
+        _strand_items.insert(key, pitm);
+        _strand_paths.append(pitm);
+    }
+    remove(&_strand_items, stale);
+}
+
+void GraphDrawer::draw(const QList<Ribbon> &ribbons)
+{
+    QGraphicsPathItem *pitm;
+    PathItemHash stale=_ribbon_items;
+    PathItemHash::iterator it;
+    quint64 key;
+    foreach (const Ribbon &r, ribbons) {
+        key=FlatteningCache::signature(r.left())+
+                FlatteningCache::signature(r.right());
+        if ((it=stale.find(key))!=stale.end()) {
+            stale.erase(it);
+            continue;
+        }
+        pitm=new QGraphicsPathItem(r.path());
+        pitm->setPen(QPen(QBrush(Qt::black), 1.));
+        pitm->setBrush(QBrush(Qt::white));
+        pitm->setZValue(RIBBON_Z_VALUE);
         _scene->addItem(pitm);
+        _ribbon_items.insert(key, pitm);
+    }
+    remove(&_ribbon_items, stale);
+}
+
+void GraphDrawer::set_scale(qreal scale)
+{
+    QList<QPolygonF> polylines;
+    bool changed=(FlatteningCache::level(scale)!=
+                  FlatteningCache::level(_scale));
+    _scale=scale;
+    if (!changed) {
+        return;
+    }
+    /* other zoom level: re-path strands with its polylines */
+    polylines=_flattening.polylines(_scale);
+    for (int i=0; i<_strand_paths.size(); ++i) {
+        _strand_paths.at(i)->setPath(polyline_path(polylines.at(i)));
+    }
+}
+
+int GraphDrawer::strand_at(const QPointF &pt, qreal radius)
+{
+    return _flattening.strand_at(pt, radius, _scale);
+}
+
+template<class ItemHash>
+void GraphDrawer::remove(ItemHash *items, const ItemHash &stale)
+{
+    typename ItemHash::const_iterator it;
+    for (it=stale.constBegin(); it!=stale.constEnd(); ++it) {
+        items->remove(it.key(), it.value());
+        /* deleting an item removes it from the scene */
+        delete it.value();
     }
 }
@@ -2,12 +2,44 @@
 #define GRAPHDRAWER_H
 
 #include <QGraphicsScene>
+#include <QHash>
+#include <QMultiHash>
+#include <QVector>
 #include "graph.h"
+#include "ribbon.h"
+#include "curveflattener.h"
 
+class QGraphicsEllipseItem; /* pre-decl */
+class QGraphicsLineItem;    /* pre-decl */
+class QGraphicsPathItem;    /* pre-decl */
+
+typedef QMultiHash<quint64, QGraphicsEllipseItem*> NodeItemHash;
+typedef QMultiHash<quint64, QGraphicsLineItem*> ArcItemHash;
+typedef QMultiHash<quint64, QGraphicsPathItem*> PathItemHash;
+
+/*
+ * Keeps scene items mapped to the nodes, arcs and strands they show.
+ * Each draw call updates its layer in place: unchanged elements keep
+ * their items, only added, moved or removed ones touch the scene.
+ * Node and arc ids change whenever a graph is parsed again, so nodes
+ * are matched on their position and arcs on their end positions.
+ * Strands have no identity, they are matched on a geometric signature
+ * that does not depend on where tracing started nor on its direction.
+ * Strands are drawn as polylines flattened for the view scale, shared
+ * with strand picking; they are only re-flattened when the scale moves
+ * to another zoom level.
+ */
 class GraphDrawer
 {
 private:
     QGraphicsScene *_scene;
+    NodeItemHash _node_items;
+    ArcItemHash _arc_items;
+    PathItemHash _strand_items;
+    PathItemHash _ribbon_items;
+    FlatteningCache _flattening;
+    QVector<QGraphicsPathItem*> _strand_paths;
+    qreal _scale;
 public:
     virtual ~GraphDrawer();
     GraphDrawer(QGraphicsScene *scene);
@@ -16,6 +48,16 @@ public:
 
     void draw(const Graph &graph);
     void draw(const QList<Entrelac> &entrelacs);
+    void draw(const QList<Ribbon> &ribbons);
+
+    inline qreal scale() const
+    { return _scale; }
+    void set_scale(qreal scale);
+    int strand_at(const QPointF &pt, qreal radius);
+
+private:
+    template<class ItemHash>
+    static void remove(ItemHash *items, const ItemHash &stale);
 };
 
 #endif // GRAPHDRAWER_H
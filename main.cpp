@@ -1,8 +1,137 @@
 #include "mainwindow.h"
+#include "generationserver.h"
+#include "generationclient.h"
+#include "consistencycheck.h"
+#include "pipeline.h"
+#include "entrelacwriter.h"
 #include <QApplication>
+#include <QTextStream>
+#include <QFile>
+#include <QFileInfo>
+
+static int server(int argc, char *argv[])
+{
+    QCoreApplication a(argc, argv);
+    GenerationServer s;
+    if (!s.listen(QString::fromLocal8Bit(argv[2]))) {
+        QTextStream(stderr) << "failed to listen on " << argv[2] << endl;
+        return 1;
+    }
+    return a.exec();
+}
+
+static int client(int argc, char *argv[])
+{
+    QCoreApplication a(argc, argv);
+    GenerationClient c;
+    QTextStream input(stdin), output(stdout);
+    QStringList requests, responses;
+    QString line;
+    if (!c.connect(QString::fromLocal8Bit(argv[2]))) {
+        QTextStream(stderr) << "failed to connect to " << argv[2] << endl;
+        return 1;
+    }
+    /* stdin lines are sent as one batch */
+    while (input.readLineInto(&line)) {
+        requests.append(line);
+    }
+    if (!c.request(requests, &responses)) {
+        QTextStream(stderr) << "request failed" << endl;
+        return 1;
+    }
+    foreach (const QString &response, responses) {
+        output << response << endl;
+    }
+    return 0;
+}
+
+static int check(int argc, char *argv[])
+{
+    QCoreApplication a(argc, argv);
+    QFile file(QString::fromLocal8Bit(argv[2]));
+    QFileInfo info(file);
+    QFile ref_file((argc>3? QString::fromLocal8Bit(argv[3]):
+                            info.path()+"/"+info.completeBaseName()+".ent"));
+    QTextStream input, output(stdout);
+    QList<Entrelac> reference;
+    Graph graph;
+    bool has_reference=false;
+    if (!file.open(QFile::ReadOnly)) {
+        QTextStream(stderr) << "can't open " << argv[2] << endl;
+        return 1;
+    }
+    input.setDevice(&file);
+    if (!graph.parse(&input)) {
+        QTextStream(stderr) << "failed to parse " << argv[2] << endl;
+        return 1;
+    }
+    /* reference strands default to the .ent file next to the graph */
+    if (ref_file.open(QFile::ReadOnly)) {
+        input.setDevice(&ref_file);
+        if (!EntrelacReader::read(&input, &reference)) {
+            QTextStream(stderr) << "failed to parse "
+                                << ref_file.fileName() << endl;
+            return 1;
+        }
+        has_reference=true;
+    } else if (argc>3) {
+        QTextStream(stderr) << "can't open " << argv[3] << endl;
+        return 1;
+    }
+    ConsistencyCheck c(&output);
+    return (c.run(graph, (has_reference? &reference: nullptr))? 0: 1);
+}
+
+static int pipeline(int argc, char *argv[])
+{
+    QCoreApplication a(argc, argv);
+    QFile in_file(QString::fromLocal8Bit(argv[2]));
+    QFile out_file(QString::fromLocal8Bit(argv[3]));
+    QTextStream input, output;
+    Graph graph;
+    Pipeline p;
+    EntrelacStyle style=WEAVE_STYLE;
+    if (argc>4&&!Entrelac::parse_style(QString::fromLocal8Bit(argv[4]),
+                                       &style)) {
+        QTextStream(stderr) << "unknown style " << argv[4] << endl;
+        return 1;
+    }
+    if (!in_file.open(QFile::ReadOnly)) {
+        QTextStream(stderr) << "can't open " << argv[2] << endl;
+        return 1;
+    }
+    if (!out_file.open(QFile::WriteOnly|QFile::Truncate)) {
+        QTextStream(stderr) << "can't open " << argv[3] << endl;
+        return 1;
+    }
+    input.setDevice(&in_file);
+    output.setDevice(&out_file);
+    EntrelacWriter writer(&output);
+    if (!p.run(&input, &graph, &writer, style)||!writer.flush()) {
+        QTextStream(stderr) << "failed to generate " << argv[3] << endl;
+        return 1;
+    }
+    return 0;
+}
 
 int main(int argc, char *argv[])
 {
+    /* EntrelacsGen --server <name> | --client <name>
+     *            | --check <graph> [<reference entrelacs>]
+     *            | --pipeline <graph> <entrelacs> [<style>] */
+    if (argc>2&&qstrcmp(argv[1], "--server")==0) {
+        return server(argc, argv);
+    }
+    if (argc>2&&qstrcmp(argv[1], "--client")==0) {
+        return client(argc, argv);
+    }
+    if (argc>2&&qstrcmp(argv[1], "--check")==0) {
+        return check(argc, argv);
+    }
+    if (argc>3&&qstrcmp(argv[1], "--pipeline")==0) {
+        return pipeline(argc, argv);
+    }
+
     QApplication a(argc, argv);
     MainWindow w;
     w.show();
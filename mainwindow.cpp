@@ -1,5 +1,6 @@
 #include "mainwindow.h"
 #include "ui_mainwindow.h"
+#include "symmetry.h"
 
 #include <QGraphicsView>
 #include <QGraphicsScene>
@@ -7,8 +8,16 @@
 #include <QMessageBox>
 #include <QFile>
 #include <QTextStream>
+#include <QWheelEvent>
+#include <QMouseEvent>
+#include <QStatusBar>
+#include <QActionGroup>
+#include <QtMath>
 #include <QDebug>
 
+#define ZOOM_STEP 1.0015        /* scale factor per wheel delta unit */
+#define PICK_RADIUS 4.          /* strand picking radius in pixels */
+
 #define ERR_MESSAGE(title, content) \
     QMessageBox::critical(this, tr(title), tr(content), QMessageBox::Ok)
 #define INF_MESSAGE(title, content) \
@@ -25,8 +34,10 @@ MainWindow::~MainWindow()
 
 MainWindow::MainWindow(QWidget *parent) :
     QMainWindow(parent),
-    ui(new Ui::MainWindow)
+    ui(new Ui::MainWindow),
+    _style(WEAVE_STYLE)
 {
+    QActionGroup *styles;
     /* variables and allocation */
     _view=new QGraphicsView(this);
     _scene=new QGraphicsScene(this);
@@ -34,7 +45,22 @@ MainWindow::MainWindow(QWidget *parent) :
     /* parameters */
     ui->setupUi(this);
     _view->setScene(_scene);
+    _view->setTransformationAnchor(QGraphicsView::AnchorUnderMouse);
+    _view->viewport()->installEventFilter(this);
     setCentralWidget(_view);
+    /* style actions, data is the EntrelacStyle they select */
+    styles=new QActionGroup(this);
+    ui->actionTissage->setData(WEAVE_STYLE);
+    ui->actionTissageArrondi->setData(ROUND_WEAVE_STYLE);
+    ui->actionTissageAngles->setData(CORNER_WEAVE_STYLE);
+    ui->actionEnroulement->setData(COIL_STYLE);
+    ui->actionEnroulementArrondi->setData(ROUND_COIL_STYLE);
+    ui->actionEnroulementAngles->setData(CORNER_COIL_STYLE);
+    foreach (QAction *action, ui->menuStyle->actions()) {
+        if (!action->isSeparator()) {
+            styles->addAction(action);
+        }
+    }
     /* connections */
     /* - ui components - */
     connect(ui->actionQuitter, &QAction::triggered,
@@ -49,6 +75,39 @@ MainWindow::MainWindow(QWidget *parent) :
             this, &MainWindow::about);
     connect(ui->action_propos_de_Qt, &QAction::triggered,
             qApp, &QApplication::aboutQt);
+    connect(styles, &QActionGroup::triggered,
+            this, &MainWindow::select_style);
+}
+
+bool MainWindow::eventFilter(QObject *watched, QEvent *event)
+{
+    QWheelEvent *wheel;
+    QMouseEvent *mouse;
+    qreal factor;
+    int strand;
+    if (watched!=_view->viewport()) {
+        return QMainWindow::eventFilter(watched, event);
+    }
+    if (event->type()==QEvent::Wheel) {
+        /* zoom, strands are re-flattened when the level changes */
+        wheel=static_cast<QWheelEvent*>(event);
+        factor=qPow(ZOOM_STEP, wheel->angleDelta().y());
+        _view->scale(factor, factor);
+        _graph_drawer->set_scale(_view->transform().m11());
+        return true;
+    }
+    if (event->type()==QEvent::MouseButtonPress) {
+        /* pick on the same polylines as the ones drawn */
+        mouse=static_cast<QMouseEvent*>(event);
+        strand=_graph_drawer->strand_at(_view->mapToScene(mouse->pos()),
+                                        PICK_RADIUS/_graph_drawer->scale());
+        if (strand<0) {
+            statusBar()->clearMessage();
+        } else {
+            statusBar()->showMessage(tr("Strand %1").arg(strand));
+        }
+    }
+    return QMainWindow::eventFilter(watched, event);
 }
 
 void MainWindow::open()
@@ -74,7 +133,7 @@ void MainWindow::open()
     }
     file.close();
     _graph_drawer->draw(_graph);
-    _graph_drawer->draw(_graph.entrelacs());
+    draw_entrelacs();
     INF_MESSAGE("Graph loaded", "Graph loaded!");
 }
 
@@ -94,7 +153,7 @@ void MainWindow::save()
         return;
     }
     output.setDevice(&file);
-    if (!_graph.save(&output)) {
+    if (!_graph.save(&output, true)) {
         ERR_MESSAGE("Save graph error", "Failed to save graph.");
         file.close();
         return;
@@ -115,3 +174,22 @@ void MainWindow::about()
 
 }
 
+void MainWindow::select_style(QAction *action)
+{
+    EntrelacStyle style=EntrelacStyle(action->data().toInt());
+    if (style==_style) {
+        return;
+    }
+    _style=style;
+    /* strands of the new style replace the drawn ones */
+    draw_entrelacs();
+}
+
+void MainWindow::draw_entrelacs()
+{
+    QList<Entrelac> entrelacs;
+    entrelacs=_graph.entrelacs(Symmetry::detect(_graph), _style);
+    _graph_drawer->draw(Ribbon::generate_from(entrelacs));
+    _graph_drawer->draw(entrelacs);
+}
+
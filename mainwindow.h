@@ -7,6 +7,7 @@
 
 class QGraphicsView;    /* pre-decl */
 class QGraphicsScene;   /* pre-decl */
+class QAction;          /* pre-decl */
 
 namespace Ui {
     class MainWindow;
@@ -21,17 +22,25 @@ private:
     QGraphicsScene *_scene;
     GraphDrawer *_graph_drawer;
     Graph _graph;
+    EntrelacStyle _style;
 
 public:
     virtual ~MainWindow();
     explicit MainWindow(QWidget *parent = 0);
 
+protected:
+    bool eventFilter(QObject *watched, QEvent *event);
+
 private slots:
     /* ui slots */
     void open();
     void save();
     void close();
     void about();
+    void select_style(QAction *action);
+
+private:
+    void draw_entrelacs();
 };
 
 #endif // MAINWINDOW_H
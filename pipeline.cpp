@@ -0,0 +1,109 @@
+#include "pipeline.h"
+#include "graphbuilder.h"
+#include "boundedqueue.h"
+#include "entrelacwriter.h"
+
+#include <QtConcurrent>
+#include <QTextStream>
+
+typedef QVector<GraphRecord> GraphRecordBatch;
+
+/* sink feeding the export stage */
+class QueueSink : public EntrelacSink
+{
+private:
+    BoundedQueue<Entrelac> *_queue;
+public:
+    virtual ~QueueSink() {}
+    QueueSink(BoundedQueue<Entrelac> *queue) :
+        _queue(queue)
+    {}
+    virtual bool consume(const Entrelac &entrelac)
+    { return _queue->push(entrelac); }
+};
+
+Pipeline::~Pipeline()
+{
+
+}
+
+Pipeline::Pipeline(int capacity, int batch_size) :
+    _capacity(capacity),
+    _batch_size(batch_size)
+{
+
+}
+
+bool Pipeline::run(QTextStream *input, Graph *graph, EntrelacSink *sink,
+                   EntrelacStyle style)
+{
+    return build(input, graph)&&generate(*graph, sink, style);
+}
+
+bool Pipeline::build(QTextStream *input, Graph *graph)
+{
+    BoundedQueue<GraphRecordBatch> records(_capacity);
+    GraphRecordBatch batch;
+    GraphBuilder builder;
+    QFuture<bool> parser;
+    graph->clear();
+    /* parse stage */
+    parser=QtConcurrent::run([&]() -> bool {
+        QString line;
+        GraphRecord record;
+        GraphRecordBatch pending;
+        bool ok=true;
+        pending.reserve(_batch_size);
+        while (ok&&input->readLineInto(&line)) {
+            if (!(ok=Graph::parse_line(line, &record))) {
+                break;
+            }
+            if (record.type!=COMMENT_RECORD) {
+                pending.append(record);
+            }
+            if (pending.size()>=_batch_size) {
+                ok=records.push(pending);
+                pending.clear();
+                pending.reserve(_batch_size);
+            }
+        }
+        if (ok&&!pending.isEmpty()) {
+            ok=records.push(pending);
+        }
+        records.close();
+        return ok;
+    });
+    /* collect records while parsing goes on, build afterwards */
+    while (records.pop(&batch)) {
+        foreach (const GraphRecord &record, batch) {
+            builder.apply(record);
+        }
+    }
+    return parser.result()&&builder.build(graph);
+}
+
+bool Pipeline::generate(const Graph &graph, EntrelacSink *sink,
+                        EntrelacStyle style)
+{
+    BoundedQueue<Entrelac> strands(_capacity);
+    QueueSink queue_sink(&strands);
+    Entrelac entrelac((QPointF()));
+    QFuture<bool> generator;
+    bool ok=true;
+    /* generate stage */
+    generator=QtConcurrent::run([&]() -> bool {
+        bool ok=Entrelac::generate_from(graph, &queue_sink, style);
+        strands.close();
+        return ok;
+    });
+    /* export stage, consumes strands as they close */
+    while (strands.pop(&entrelac)) {
+        if (!sink->consume(entrelac)) {
+            /* unblock generator */
+            strands.close();
+            ok=false;
+            break;
+        }
+    }
+    return generator.result()&&ok;
+}
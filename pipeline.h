@@ -0,0 +1,40 @@
+#ifndef PIPELINE_H
+#define PIPELINE_H
+
+#include "graph.h"
+
+class QTextStream;  /* pre-decl */
+class EntrelacSink; /* pre-decl */
+
+#define PIPELINE_QUEUE_CAPACITY 64
+#define PIPELINE_BATCH_SIZE 4096
+
+/*
+ * Streaming parse -> build -> generate -> export.
+ * Lines are parsed on a worker thread while the calling thread collects
+ * record batches into a GraphBuilder, which only stores positions and
+ * index pairs: the graph is built at once after parsing. Strands are
+ * then generated on a worker thread and handed to the sink as soon as
+ * they close. Stages are linked by bounded queues. Generation needs the
+ * whole adjacency, so it starts once the graph is complete.
+ */
+class Pipeline
+{
+private:
+    int _capacity;
+    int _batch_size;
+public:
+    virtual ~Pipeline();
+    Pipeline(int capacity=PIPELINE_QUEUE_CAPACITY,
+             int batch_size=PIPELINE_BATCH_SIZE);
+
+    bool run(QTextStream *input, Graph *graph, EntrelacSink *sink,
+             EntrelacStyle style=WEAVE_STYLE);
+
+private:
+    bool build(QTextStream *input, Graph *graph);
+    bool generate(const Graph &graph, EntrelacSink *sink,
+                  EntrelacStyle style);
+};
+
+#endif // PIPELINE_H
@@ -0,0 +1,288 @@
+#include "ribbon.h"
+
+#include <QtConcurrent>
+#include <QtMath>
+
+#define RIBBON_EPSILON 1e-9
+#define RIBBON_SPLIT_COS 0.7071067811865476 /* split above 45 degrees */
+
+struct RibbonJob
+{
+    const Entrelac *entrelac;
+    Ribbon ribbon;
+};
+
+static qreal length(const QPointF &v)
+{
+    return qSqrt(QPointF::dotProduct(v, v));
+}
+
+static QPointF unit(const QPointF &v)
+{
+    qreal len=length(v);
+    return (len<RIBBON_EPSILON? QPointF(): v/len);
+}
+
+static QPointF left_normal(const QPointF &v)
+{
+    return unit(QPointF(-v.y(), v.x()));
+}
+
+static QPointF start_tangent(const QPointF p[4])
+{
+    /* first non degenerate control polygon direction */
+    for (int i=1; i<4; ++i) {
+        if (length(p[i]-p[0])>RIBBON_EPSILON) {
+            return unit(p[i]-p[0]);
+        }
+    }
+    return QPointF();
+}
+
+static QPointF end_tangent(const QPointF p[4])
+{
+    for (int i=2; i>=0; --i) {
+        if (length(p[3]-p[i])>RIBBON_EPSILON) {
+            return unit(p[3]-p[i]);
+        }
+    }
+    return QPointF();
+}
+
+static bool intersect(const QPointF &p, const QPointF &dp,
+                      const QPointF &q, const QPointF &dq, QPointF *pt)
+{
+    qreal cross=dp.x()*dq.y()-dp.y()*dq.x();
+    qreal s;
+    if (qAbs(cross)<RIBBON_EPSILON) {
+        return false;
+    }
+    s=((q.x()-p.x())*dq.y()-(q.y()-p.y())*dq.x())/cross;
+    (*pt)=p+s*dp;
+    return true;
+}
+
+static CubicCurve line_to(const QPointF &src, const QPointF &dst)
+{
+    return CubicCurve(src+(dst-src)/3, src+2*(dst-src)/3, dst);
+}
+
+static void offset_cubic(const QPointF p[4], qreal d, int depth,
+                         CubicCurveList *out, QPointF *start)
+{
+    QPointF t0, t3, n0, n3, n12, mid, q[4];
+    QPointF left[4], right[4], ab, bc, cd, abc, bcd, abcd;
+    qreal limit;
+    t0=start_tangent(p);
+    t3=end_tangent(p);
+    if (depth<RIBBON_MAX_DEPTH&&
+        QPointF::dotProduct(t0, t3)<RIBBON_SPLIT_COS) {
+        /* too much turn for a single offset cubic: split at t=0.5 */
+        ab=(p[0]+p[1])/2; bc=(p[1]+p[2])/2; cd=(p[2]+p[3])/2;
+        abc=(ab+bc)/2; bcd=(bc+cd)/2; abcd=(abc+bcd)/2;
+        left[0]=p[0]; left[1]=ab; left[2]=abc; left[3]=abcd;
+        right[0]=abcd; right[1]=bcd; right[2]=cd; right[3]=p[3];
+        offset_cubic(left, d, depth+1, out, start);
+        offset_cubic(right, d, depth+1, out, nullptr);
+        return;
+    }
+    /* Tiller-Hanson: offset control polygon edges, intersect them */
+    n0=left_normal(t0);
+    n3=left_normal(t3);
+    n12=left_normal(p[2]-p[1]);
+    if (n12.isNull()) {
+        n12=unit(n0+n3);
+    }
+    mid=p[2]-p[1];
+    if (mid.isNull()) {
+        mid=t0+t3;
+    }
+    q[0]=p[0]+d*n0;
+    q[3]=p[3]+d*n3;
+    limit=RIBBON_MITER_LIMIT*(length(p[3]-p[0])+qAbs(d));
+    if (!intersect(q[0], t0, p[1]+d*n12, mid, &q[1])||
+        length(q[1]-q[0])>limit) {
+        q[1]=p[1]+d*n0;
+    }
+    if (!intersect(p[2]+d*n12, mid, q[3], t3, &q[2])||
+        length(q[2]-q[3])>limit) {
+        q[2]=p[2]+d*n3;
+    }
+    if (start!=nullptr) {
+        (*start)=q[0];
+    }
+    out->append(CubicCurve(q[1], q[2], q[3]));
+}
+
+static void join(const QPointF &src, const QPointF &t_in,
+                 const QPointF &dst, const QPointF &t_out,
+                 const QPointF &center, qreal d, CubicCurveList *out)
+{
+    QPointF miter;
+    if (length(dst-src)<RIBBON_EPSILON) {
+        return;
+    }
+    /* miter join, bevel when the miter gets too long */
+    if (intersect(src, t_in, dst, t_out, &miter)&&
+        length(miter-center)<=RIBBON_MITER_LIMIT*qAbs(d)&&
+        QPointF::dotProduct(miter-src, t_in)>0) {
+        out->append(line_to(src, miter));
+        out->append(line_to(miter, dst));
+    } else {
+        out->append(line_to(src, dst));
+    }
+}
+
+static bool is_closed(const Entrelac &outline)
+{
+    return (!outline.subcurves().isEmpty()&&
+            length(outline.subcurves().last().dst_pt()-outline.start())<
+            RIBBON_EPSILON);
+}
+
+static void append_forward(Entrelac *band, const Entrelac &outline)
+{
+    foreach (const CubicCurve &cc, outline.subcurves()) {
+        band->add_subcurve(cc);
+    }
+}
+
+static void append_reversed(Entrelac *band, const Entrelac &outline)
+{
+    CubicCurveList subcurves=outline.subcurves();
+    /* curve k goes backwards from its end to the end of curve k-1 */
+    for (int k=subcurves.size()-1; k>=0; --k) {
+        band->add_subcurve(CubicCurve(
+                subcurves.at(k).dst_ctl_pt(), subcurves.at(k).src_ctl_pt(),
+                (k>0? subcurves.at(k-1).dst_pt(): outline.start())));
+    }
+}
+
+static QPointF end_point(const Entrelac &outline)
+{
+    return (outline.subcurves().isEmpty()?
+                outline.start(): outline.subcurves().last().dst_pt());
+}
+
+Ribbon::~Ribbon()
+{
+
+}
+
+Ribbon::Ribbon() :
+    _left(QPointF()),
+    _right(QPointF())
+{
+
+}
+
+Ribbon::Ribbon(const Entrelac &left, const Entrelac &right) :
+    _left(left),
+    _right(right)
+{
+
+}
+
+QList<Entrelac> Ribbon::outline() const
+{
+    QList<Entrelac> outlines;
+    Entrelac band(_left.start());
+    bool closed=(is_closed(_left)&&is_closed(_right));
+    /*
+     * The right side runs backwards, so that every piece of the band
+     * winds the same way: with winding fill the band stays filled where
+     * it crosses itself, while the inside of its loops stays empty.
+     */
+    append_forward(&band, _left);
+    if (closed) {
+        outlines.append(band);
+        band=Entrelac(end_point(_right));
+    } else {
+        /* open strand: one outline with flat end caps */
+        band.add_subcurve(line_to(end_point(_left), end_point(_right)));
+    }
+    append_reversed(&band, _right);
+    if (!closed) {
+        band.add_subcurve(line_to(_right.start(), _left.start()));
+    }
+    outlines.append(band);
+    return outlines;
+}
+
+QPainterPath Ribbon::path() const
+{
+    QPainterPath path;
+    path.setFillRule(Qt::WindingFill);
+    foreach (const Entrelac &e, outline()) {
+        path.moveTo(e.start());
+        foreach (const CubicCurve &cc, e.subcurves()) {
+            path.cubicTo(cc.src_ctl_pt(), cc.dst_ctl_pt(), cc.dst_pt());
+        }
+        path.closeSubpath();
+    }
+    return path;
+}
+
+Ribbon Ribbon::generate_from(const Entrelac &entrelac, qreal width)
+{
+    return Ribbon(offset(entrelac, width/2), offset(entrelac, -width/2));
+}
+
+QList<Ribbon> Ribbon::generate_from(const QList<Entrelac> &entrelacs,
+                                    qreal width)
+{
+    QVector<RibbonJob> jobs;
+    QList<Ribbon> ribbons;
+    jobs.reserve(entrelacs.size());
+    for (int i=0; i<entrelacs.size(); ++i) {
+        jobs.append(RibbonJob{&entrelacs.at(i), Ribbon()});
+    }
+    /* strands are independent, offset them in parallel */
+    QtConcurrent::blockingMap(jobs, [width](RibbonJob &job) {
+        job.ribbon=generate_from(*job.entrelac, width);
+    });
+    ribbons.reserve(jobs.size());
+    foreach (const RibbonJob &job, jobs) {
+        ribbons.append(job.ribbon);
+    }
+    return ribbons;
+}
+
+Entrelac Ribbon::offset(const Entrelac &entrelac, qreal d)
+{
+    CubicCurveList pieces, subcurves=entrelac.subcurves();
+    QPointF p[4], first_start, start, end, t_in, t_first;
+    bool closed;
+    if (subcurves.isEmpty()) {
+        return Entrelac(entrelac.start());
+    }
+    p[3]=entrelac.start();
+    for (int k=0; k<subcurves.size(); ++k) {
+        p[0]=p[3];
+        p[1]=subcurves.at(k).src_ctl_pt();
+        p[2]=subcurves.at(k).dst_ctl_pt();
+        p[3]=subcurves.at(k).dst_pt();
+        if (k==0) {
+            offset_cubic(p, d, 0, &pieces, &first_start);
+            t_first=start_tangent(p);
+        } else {
+            /* connect previous offset end to this offset start */
+            CubicCurveList curve;
+            offset_cubic(p, d, 0, &curve, &start);
+            join(end, t_in, start, start_tangent(p), p[0], d, &pieces);
+            pieces+=curve;
+        }
+        end=pieces.last().dst_pt();
+        t_in=end_tangent(p);
+    }
+    /* close the outline on strand start */
+    closed=(length(p[3]-entrelac.start())<RIBBON_EPSILON);
+    if (closed) {
+        join(end, t_in, first_start, t_first, p[3], d, &pieces);
+    }
+    Entrelac outline(first_start);
+    foreach (const CubicCurve &cc, pieces) {
+        outline.add_subcurve(cc);
+    }
+    return outline;
+}
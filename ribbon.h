@@ -0,0 +1,46 @@
+#ifndef RIBBON_H
+#define RIBBON_H
+
+#include <QPainterPath>
+#include "graph.h"
+
+#define RIBBON_WIDTH 10.
+#define RIBBON_MITER_LIMIT 4.
+#define RIBBON_MAX_DEPTH 4
+
+/*
+ * Band of constant width following an entrelac, outlined by its two
+ * offset curves (left and right of the direction of travel). Offset
+ * curves are cubic approximations, so the outline can be drawn and
+ * exported like any entrelac. outline() joins them in closed curves,
+ * one for an open strand and two for a closed one, that path() and
+ * exporters share.
+ */
+class Ribbon
+{
+private:
+    Entrelac _left;
+    Entrelac _right;
+public:
+    virtual ~Ribbon();
+    Ribbon();
+    Ribbon(const Entrelac &left, const Entrelac &right);
+
+    inline Entrelac left() const
+    { return _left; }
+    inline Entrelac right() const
+    { return _right; }
+
+    QList<Entrelac> outline() const;
+    QPainterPath path() const;
+
+    static Ribbon generate_from(const Entrelac &entrelac,
+                                qreal width=RIBBON_WIDTH);
+    static QList<Ribbon> generate_from(const QList<Entrelac> &entrelacs,
+                                       qreal width=RIBBON_WIDTH);
+
+private:
+    static Entrelac offset(const Entrelac &entrelac, qreal d);
+};
+
+#endif // RIBBON_H
@@ -0,0 +1,172 @@
+#include "symmetry.h"
+
+#include <QtMath>
+#include <QPair>
+#include <QMultiHash>
+
+typedef QPair<qint64, qint64> PositionKey;
+typedef QPair<const Node*, const Node*> NodePair;
+
+/* bin of SYMMETRY_EPSILON side containing pt */
+static PositionKey position_key(const QPointF &pt)
+{
+    return PositionKey(qint64(qFloor(pt.x()/SYMMETRY_EPSILON)),
+                       qint64(qFloor(pt.y()/SYMMETRY_EPSILON)));
+}
+
+static NodePair node_pair(const Node *a, const Node *b)
+{
+    /* arcs are matched regardless of their orientation */
+    return (a<b? NodePair(a, b): NodePair(b, a));
+}
+
+/* nodes by position and arcs by end nodes, built once per graph */
+class SymmetryIndex
+{
+public:
+    QList<const Node*> nodes;
+    QList<const Arc*> arcs;
+    QMultiHash<PositionKey, const Node*> nodes_by_pos;
+    QHash<NodePair, const Arc*> arcs_by_nodes;
+
+    SymmetryIndex(const Graph &graph) :
+        nodes(graph.nodes()), arcs(graph.arcs()),
+        nodes_by_pos(), arcs_by_nodes()
+    {
+        nodes_by_pos.reserve(nodes.size());
+        foreach (const Node *n, nodes) {
+            nodes_by_pos.insert(position_key(n->position()), n);
+        }
+        arcs_by_nodes.reserve(arcs.size());
+        foreach (const Arc *a, arcs) {
+            arcs_by_nodes.insert(node_pair(a->const_src(), a->const_dst()),
+                                 a);
+        }
+    }
+
+    /* closest node within SYMMETRY_EPSILON of pt, a point near a bin
+     * edge may have its node in a neighbouring bin */
+    const Node *node_at(const QPointF &pt) const
+    {
+        QMultiHash<PositionKey, const Node*>::const_iterator it;
+        PositionKey key=position_key(pt), k;
+        const Node *closest=nullptr;
+        qreal d, min_d=SYMMETRY_EPSILON;
+        for (int dx=-1; dx<=1; ++dx) {
+            for (int dy=-1; dy<=1; ++dy) {
+                k=PositionKey(key.first+dx, key.second+dy);
+                for (it=nodes_by_pos.constFind(k);
+                     it!=nodes_by_pos.constEnd()&&it.key()==k; ++it) {
+                    d=qMax(qAbs(it.value()->position().x()-pt.x()),
+                           qAbs(it.value()->position().y()-pt.y()));
+                    if (d<=min_d) {
+                        min_d=d;
+                        closest=it.value();
+                    }
+                }
+            }
+        }
+        return closest;
+    }
+};
+
+Symmetry::~Symmetry()
+{
+
+}
+
+Symmetry::Symmetry(const QPointF &center, int order) :
+    _center(center),
+    _order(qMax(order, 1))
+{
+
+}
+
+QTransform Symmetry::transform(int k) const
+{
+    QTransform t;
+    t.translate(_center.x(), _center.y());
+    t.rotateRadians((2*M_PI*k)/_order);
+    t.translate(-_center.x(), -_center.y());
+    return t;
+}
+
+bool Symmetry::map_arcs(const Graph &graph, ArcMap *arc_map,
+                        QSet<const Arc*> *swapped) const
+{
+    return map_arcs(SymmetryIndex(graph), arc_map, swapped);
+}
+
+bool Symmetry::map_arcs(const SymmetryIndex &index, ArcMap *arc_map,
+                        QSet<const Arc*> *swapped) const
+{
+    QHash<const Node*, const Node*> node_map;
+    QTransform t=transform(1);
+    const Node *image;
+    const Arc *mapped;
+    arc_map->clear();
+    if (swapped!=nullptr) {
+        swapped->clear();
+    }
+    /* map nodes through one rotation step */
+    node_map.reserve(index.nodes.size());
+    foreach (const Node *n, index.nodes) {
+        if ((image=index.node_at(t.map(n->position())))==nullptr) {
+            return false;
+        }
+        node_map.insert(n, image);
+    }
+    /* map arcs through mapped end nodes */
+    arc_map->reserve(index.arcs.size());
+    foreach (const Arc *a, index.arcs) {
+        mapped=index.arcs_by_nodes.value(
+                    node_pair(node_map.value(a->const_src()),
+                              node_map.value(a->const_dst())));
+        if (mapped==nullptr) {
+            arc_map->clear();
+            return false;
+        }
+        arc_map->insert(a, mapped);
+        /* image arc oriented the other way */
+        if (swapped!=nullptr&&
+            node_map.value(a->const_src())!=mapped->const_src()) {
+            swapped->insert(a);
+        }
+    }
+    return true;
+}
+
+Entrelac Symmetry::map(const Entrelac &entrelac, const QTransform &t)
+{
+    Entrelac mapped(t.map(entrelac.start()));
+    foreach (const CubicCurve &cc, entrelac.subcurves()) {
+        mapped.add_subcurve(CubicCurve(t.map(cc.src_ctl_pt()),
+                                       t.map(cc.dst_ctl_pt()),
+                                       t.map(cc.dst_pt())));
+    }
+    return mapped;
+}
+
+Symmetry Symmetry::detect(const Graph &graph, int max_order)
+{
+    QPointF center;
+    ArcMap arc_map;
+    SymmetryIndex index(graph);
+    if (index.nodes.isEmpty()) {
+        return Symmetry();
+    }
+    /* a rotation symmetry fixes the centroid */
+    foreach (const Node *n, index.nodes) {
+        center+=n->position();
+    }
+    center/=index.nodes.size();
+    /* keep the largest order, it generates the smaller ones it contains,
+     * every order is tested against the same index */
+    for (int order=max_order; order>1; --order) {
+        Symmetry symmetry(center, order);
+        if (symmetry.map_arcs(index, &arc_map, nullptr)) {
+            return symmetry;
+        }
+    }
+    return Symmetry(center);
+}
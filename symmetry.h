@@ -0,0 +1,51 @@
+#ifndef SYMMETRY_H
+#define SYMMETRY_H
+
+#include <QHash>
+#include <QSet>
+#include <QPointF>
+#include <QTransform>
+#include "graph.h"
+
+#define SYMMETRY_MAX_ORDER 12
+#define SYMMETRY_EPSILON 1e-3
+
+typedef QHash<const Arc*, const Arc*> ArcMap;
+
+class SymmetryIndex; /* pre-decl */
+
+/*
+ * N-fold rotational symmetry around a center. Order 1 means no symmetry.
+ * Used to generate the entrelacs of one fundamental domain and obtain
+ * the others by rotating curve control points.
+ */
+class Symmetry
+{
+private:
+    QPointF _center;
+    int _order;
+public:
+    virtual ~Symmetry();
+    Symmetry(const QPointF &center=QPointF(), int order=1);
+
+    inline QPointF center() const
+    { return _center; }
+    inline int order() const
+    { return _order; }
+    inline bool is_trivial() const
+    { return _order<2; }
+
+    QTransform transform(int k) const;
+    bool map_arcs(const Graph &graph, ArcMap *arc_map,
+                  QSet<const Arc*> *swapped=nullptr) const;
+
+    static Entrelac map(const Entrelac &entrelac, const QTransform &t);
+    static Symmetry detect(const Graph &graph,
+                           int max_order=SYMMETRY_MAX_ORDER);
+
+private:
+    bool map_arcs(const SymmetryIndex &index, ArcMap *arc_map,
+                  QSet<const Arc*> *swapped) const;
+};
+
+#endif // SYMMETRY_H